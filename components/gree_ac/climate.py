@@ -1,14 +1,32 @@
 #based on: https://github.com/DomiStyle/esphome-panasonic-ac
+from pathlib import Path
+import re
+
 from esphome.const import (
     CONF_ID,
     CONF_NAME,
     CONF_ICON,
+    CONF_FAN_MODE,
+    CONF_MODE,
+    CONF_OPTIMISTIC,
+    CONF_PLATFORM,
+    CONF_RESTORE_STATE,
+    CONF_TARGET_TEMPERATURE,
+    CONF_TIME_ID,
+    ENTITY_CATEGORY_DIAGNOSTIC,
+    STATE_CLASS_MEASUREMENT,
+    STATE_CLASS_TOTAL_INCREASING,
+    UNIT_BYTES,
+    UNIT_HOUR,
+    UNIT_MILLISECOND,
+    UNIT_PERCENT,
 )
 import esphome.codegen as cg
 import esphome.config_validation as cv
-from esphome.components import uart, climate, sensor, select, switch
+import esphome.final_validate as fv
+from esphome.components import uart, climate, sensor, select, switch, button, time
 
-AUTO_LOAD = ["switch", "sensor", "select"]
+AUTO_LOAD = ["switch", "sensor", "select", "button"]
 DEPENDENCIES = ["uart"]
 
 gree_ac_ns = cg.esphome_ns.namespace("gree_ac")
@@ -18,12 +36,34 @@ GreeAC = gree_ac_ns.class_(
 gree_ac_cnt_ns = gree_ac_ns.namespace("CNT")
 GreeACCNT = gree_ac_cnt_ns.class_("GreeACCNT", GreeAC, cg.Component)
 
+GreeACPreset = gree_ac_ns.class_("GreeACPreset")
+
+LocalControl = gree_ac_cnt_ns.enum("LocalControl", is_class=True)
+LOCAL_CONTROL_ALGORITHMS = {
+    "hysteresis": LocalControl.Hysteresis,
+    "pi": LocalControl.PI,
+}
+LocalControlOutput = gree_ac_cnt_ns.enum("LocalControlOutput", is_class=True)
+LOCAL_CONTROL_OUTPUTS = {
+    "setpoint": LocalControlOutput.Setpoint,
+    "fan": LocalControlOutput.Fan,
+}
+
 GreeACSwitch = gree_ac_ns.class_(
     "GreeACSwitch", switch.Switch, cg.Component
 )
 GreeACSelect = gree_ac_ns.class_(
     "GreeACSelect", select.Select, cg.Component
 )
+GreeACCaptureButton = gree_ac_ns.class_(
+    "GreeACCaptureButton", button.Button, cg.Parented.template(GreeAC)
+)
+GreeACHistoryButton = gree_ac_ns.class_(
+    "GreeACHistoryButton", button.Button, cg.Parented.template(GreeAC)
+)
+GreeACTraceButton = gree_ac_ns.class_(
+    "GreeACTraceButton", button.Button, cg.Parented.template(GreeAC)
+)
 
 
 CONF_HORIZONTAL_SWING_SELECT    = "horizontal_swing_select"
@@ -44,47 +84,316 @@ CONF_QUIET_SELECT               = "quiet_select"
 
 CONF_CURRENT_TEMPERATURE_SENSOR = "current_temperature_sensor"
 
-QUIET_OPTIONS = [
-    "Off",
-    "On",
-    "Auto",
-]
-
-HORIZONTAL_SWING_OPTIONS = [
-    "Off",
-    "Swing - Full",
-    "Constant - Left",
-    "Constant - Mid-Left",
-    "Constant - Middle",
-    "Constant - Mid-Right",
-    "Constant - Right",
-]
-
-
-VERTICAL_SWING_OPTIONS = [
-    "Off",
-    "Swing - Full",
-    "Swing - Down",
-    "Swing - Mid-Down",
-    "Swing - Middle",
-    "Swing - Mid-Up",
-    "Swing - Up",
-    "Constant - Down",
-    "Constant - Mid-Down",
-    "Constant - Middle",
-    "Constant - Mid-Up",
-    "Constant - Up",
-]
-
-DISPLAY_OPTIONS = [
-    "Set temperature",
-    "Actual temperature",
-]
-
-DISPLAY_UNIT_OPTIONS = [
-    "C",
-    "F",
-]
+CONF_SYNC_TIME_INTERVAL         = "sync_time_interval"
+CONF_MAC_REPORT_INTERVAL        = "mac_report_interval"
+
+CONF_PRESETS                    = "presets"
+CONF_VERTICAL_SWING             = "vertical_swing"
+CONF_HORIZONTAL_SWING           = "horizontal_swing"
+CONF_QUIET                      = "quiet"
+CONF_LIGHT                      = "light"
+CONF_IONIZER                    = "ionizer"
+CONF_SLEEP                      = "sleep"
+CONF_XFAN                       = "xfan"
+CONF_POWERSAVE                  = "powersave"
+CONF_TURBO                      = "turbo"
+
+CONF_UNIT_BUS_UTILIZATION       = "unit_bus_utilization"
+CONF_MODULE_BUS_UTILIZATION     = "module_bus_utilization"
+CONF_STARTUP_TIME               = "startup_time"
+CONF_HEAP_FREE                  = "heap_free"
+CONF_HEAP_MIN_FREE              = "heap_min_free"
+CONF_HEAP_MAX_BLOCK             = "heap_max_block"
+CONF_STACK_MIN_FREE             = "stack_min_free"
+CONF_AUTO_DETECT                = "auto_detect"
+CONF_STATE_SAVE_INTERVAL        = "state_save_interval"
+CONF_FLASH_WRITES               = "flash_writes"
+CONF_LINK_QUALITY               = "link_quality"
+CONF_SNIFFER                    = "sniffer"
+CONF_STOCK_COMMAND_INTERVAL     = "stock_command_interval"
+CONF_STOCK_RESPONSE_LATENCY     = "stock_response_latency"
+CONF_FIELD_MAP                  = "field_map"
+CONF_TELEMETRY                  = "telemetry"
+CONF_PROTOCOL_COUNTERS          = "protocol_counters"
+CONF_LOOP_PROFILING             = "loop_profiling"
+CONF_PACKET_CAPTURE             = "packet_capture"
+CONF_DEPTH                      = "depth"
+CONF_DUMP_BUTTON                = "dump_button"
+CONF_COMMAND_TRACE              = "command_trace"
+CONF_FILE                       = "file"
+CONF_RUNTIME_STATS              = "runtime_stats"
+CONF_HISTORY                    = "history"
+CONF_SIZE                       = "size"
+CONF_IFEEL_FORWARDING           = "ifeel_forwarding"
+CONF_INTERVAL                   = "interval"
+CONF_DEADBAND                   = "deadband"
+CONF_LOCAL_CONTROL              = "local_control"
+CONF_ALGORITHM                  = "algorithm"
+CONF_OUTPUT                     = "output"
+CONF_UPDATE_INTERVAL            = "update_interval"
+CONF_MIN_COMMAND_INTERVAL       = "min_command_interval"
+CONF_HYSTERESIS                 = "hysteresis"
+CONF_MAX_OFFSET                 = "max_offset"
+CONF_KP                         = "kp"
+CONF_KI                         = "ki"
+CONF_RESET_INTERVAL             = "reset_interval"
+CONF_CYCLES                     = "cycles"
+CONF_COMMAND                    = "command"
+CONF_BYTE                       = "byte"
+CONF_MASK                       = "mask"
+CONF_MULTIPLIER                 = "multiplier"
+CONF_OFFSET                     = "offset"
+CONF_SAMPLING_INTERVAL          = "sampling_interval"
+CONF_PUBLISH_INTERVAL           = "publish_interval"
+CONF_DELTA                      = "delta"
+
+# option lists and remappable protocol fields are declared once, in the C++ headers
+COMPONENT_DIR = Path(__file__).parent
+
+
+def _read_header(name):
+    """Header text with comments blanked out, so commented-out code is never matched"""
+    text = (COMPONENT_DIR / name).read_text(encoding="utf-8")
+    return re.sub(
+        r'"(?:\\.|[^"\\])*"|/\*.*?\*/|//[^\n]*',
+        lambda m: m.group(0) if m.group(0).startswith('"') else re.sub(r"[^\n]", " ", m.group(0)),
+        text,
+        flags=re.S,
+    )
+
+
+def _header_block(text, start):
+    """Body of the brace block opened by the first '{' after start"""
+    begin = text.index("{", start) + 1
+    depth = 1
+    for pos in range(begin, len(text)):
+        if text[pos] == "{":
+            depth += 1
+        elif text[pos] == "}":
+            depth -= 1
+            if depth == 0:
+                return text[begin:pos]
+    raise ValueError(f"unbalanced braces after offset {start}")
+
+
+def _header_options(namespace):
+    """Option strings of a namespace in gree_ac.h, in declaration order"""
+    text = _read_header("gree_ac.h")
+    match = re.search(r"\bnamespace\s+" + namespace + r"\s*\{", text)
+    if match is None:
+        raise ValueError(f"gree_ac.h: namespace {namespace} not found")
+    options = re.findall(
+        r'const char\s*\*\s*const\s+\w+\s*=\s*"([^"]*)"', _header_block(text, match.start())
+    )
+    if not options:
+        raise ValueError(f"gree_ac.h: no options parsed from namespace {namespace}")
+    return options
+
+
+def _header_fields():
+    """Names in the GREE_AC_FIELDS list of gree_ac_cnt.h"""
+    match = re.search(
+        r"#define GREE_AC_FIELDS\(X\)((?:.*\\\n)*.*)", _read_header("gree_ac_cnt.h")
+    )
+    fields = re.findall(r"X\((\w+)\)", match.group(1)) if match else []
+    if not fields:
+        raise ValueError("gree_ac_cnt.h: no fields parsed from GREE_AC_FIELDS")
+    return fields
+
+
+def _header_constant(name):
+    """Value of a numeric protocol constant in gree_ac_cnt.h"""
+    values = re.findall(r"\b" + name + r"\s*=\s*(\d+)\s*;", _read_header("gree_ac_cnt.h"))
+    if len(set(values)) != 1:
+        raise ValueError(f"gree_ac_cnt.h: expected one value of {name}, found {values}")
+    return int(values[0])
+
+
+FAN_MODE_OPTIONS = _header_options("fan_modes")
+QUIET_OPTIONS = _header_options("quiet_options")
+HORIZONTAL_SWING_OPTIONS = _header_options("horizontal_swing_options")
+VERTICAL_SWING_OPTIONS = _header_options("vertical_swing_options")
+DISPLAY_OPTIONS = _header_options("display_options")
+DISPLAY_UNIT_OPTIONS = _header_options("display_unit_options")
+FIELD_NAMES = _header_fields()
+SET_PACKET_LEN = _header_constant("SET_PACKET_LEN")
+
+# byte indices have to stay within the SET frame, everything else is a plain byte value
+FIELD_MAP_SCHEMA = cv.Schema(
+    {
+        cv.Optional(name.lower()): (
+            cv.int_range(min=0, max=SET_PACKET_LEN - 1) if name.endswith("_BYTE") else cv.uint8_t
+        )
+        for name in FIELD_NAMES
+    }
+)
+
+PRESET_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(): cv.declare_id(GreeACPreset),
+        # standard preset (ECO, SLEEP, BOOST, COMFORT, ...) or any custom name
+        cv.Required(CONF_NAME): cv.string_strict,
+        cv.Optional(CONF_MODE): cv.enum(climate.CLIMATE_MODES, upper=True),
+        cv.Optional(CONF_TARGET_TEMPERATURE): cv.temperature,
+        cv.Optional(CONF_FAN_MODE): cv.one_of(*FAN_MODE_OPTIONS),
+        cv.Optional(CONF_VERTICAL_SWING): cv.one_of(*VERTICAL_SWING_OPTIONS),
+        cv.Optional(CONF_HORIZONTAL_SWING): cv.one_of(*HORIZONTAL_SWING_OPTIONS),
+        cv.Optional(CONF_QUIET): cv.one_of(*QUIET_OPTIONS),
+        cv.Optional(CONF_LIGHT): cv.boolean,
+        cv.Optional(CONF_IONIZER): cv.boolean,
+        cv.Optional(CONF_SLEEP): cv.boolean,
+        cv.Optional(CONF_XFAN): cv.boolean,
+        cv.Optional(CONF_POWERSAVE): cv.boolean,
+        cv.Optional(CONF_TURBO): cv.boolean,
+    }
+)
+
+# protocol health counters: YAML key -> ProtocolCounter_t in gree_ac.h
+PROTOCOL_COUNTERS = {
+    "frames_received": gree_ac_ns.COUNTER_FRAMES_RECEIVED,
+    "frames_sent": gree_ac_ns.COUNTER_FRAMES_SENT,
+    "checksum_errors": gree_ac_ns.COUNTER_CHECKSUM_ERRORS,
+    "disallowed_commands": gree_ac_ns.COUNTER_DISALLOWED_COMMANDS,
+    "overflows": gree_ac_ns.COUNTER_OVERFLOWS,
+    "reception_timeouts": gree_ac_ns.COUNTER_RECEPTION_TIMEOUTS,
+    "response_timeouts": gree_ac_ns.COUNTER_RESPONSE_TIMEOUTS,
+    "state_flaps": gree_ac_ns.COUNTER_STATE_FLAPS,
+}
+
+PROTOCOL_COUNTERS_SCHEMA = cv.Schema(
+    {
+        **{
+            cv.Optional(key): sensor.sensor_schema(
+                icon="mdi:counter",
+                accuracy_decimals=0,
+                state_class=STATE_CLASS_TOTAL_INCREASING,
+                entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+            )
+            for key in PROTOCOL_COUNTERS
+        },
+        **{
+            cv.Optional(key + "_rate"): sensor.sensor_schema(
+                unit_of_measurement="1/min",
+                icon="mdi:speedometer",
+                accuracy_decimals=1,
+                state_class=STATE_CLASS_MEASUREMENT,
+                entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+            )
+            for key in PROTOCOL_COUNTERS
+        },
+    }
+)
+
+# time is accumulated in seconds from decoded reports and published in hours
+RUNTIME_STATS = {
+    "auto_runtime": gree_ac_ns.RUNTIME_AUTO,
+    "cool_runtime": gree_ac_ns.RUNTIME_COOL,
+    "heat_runtime": gree_ac_ns.RUNTIME_HEAT,
+    "dry_runtime": gree_ac_ns.RUNTIME_DRY,
+    "fan_only_runtime": gree_ac_ns.RUNTIME_FAN_ONLY,
+    "above_setpoint": gree_ac_ns.RUNTIME_ABOVE_SETPOINT,
+    "below_setpoint": gree_ac_ns.RUNTIME_BELOW_SETPOINT,
+}
+
+RUNTIME_STATS_SCHEMA = cv.Schema(
+    {
+        # 0s keeps counting since boot
+        cv.Optional(CONF_RESET_INTERVAL, default="24h"): cv.positive_time_period_milliseconds,
+        **{
+            cv.Optional(key): sensor.sensor_schema(
+                unit_of_measurement=UNIT_HOUR,
+                icon="mdi:timer-sand",
+                accuracy_decimals=2,
+                state_class=STATE_CLASS_TOTAL_INCREASING,
+                entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+            )
+            for key in RUNTIME_STATS
+        },
+        cv.Optional(CONF_CYCLES): sensor.sensor_schema(
+            icon="mdi:power-cycle",
+            accuracy_decimals=0,
+            state_class=STATE_CLASS_TOTAL_INCREASING,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
+    }
+)
+
+# mostly one byte per minute, so the default covers about a day
+HISTORY_SCHEMA = cv.Schema(
+    {
+        cv.Optional(CONF_SIZE, default=1536): cv.int_range(min=16, max=16384),
+        cv.Optional(CONF_DUMP_BUTTON): button.button_schema(
+            GreeACHistoryButton,
+            icon="mdi:history",
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
+    }
+)
+
+PACKET_CAPTURE_SCHEMA = cv.Schema(
+    {
+        # 68 bytes per frame, the ring is allocated at boot
+        cv.Optional(CONF_DEPTH, default=16): cv.int_range(min=1, max=64),
+        cv.Optional(CONF_DUMP_BUTTON): button.button_schema(
+            GreeACCaptureButton,
+            icon="mdi:record-rec",
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
+    }
+)
+
+COMMAND_TRACE_SCHEMA = cv.Schema(
+    {
+        cv.Optional(CONF_DEPTH, default=64): cv.int_range(min=1, max=255),
+        cv.Optional(CONF_DUMP_BUTTON): button.button_schema(
+            GreeACTraceButton,
+            icon="mdi:chart-timeline",
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
+        # host builds only, rewritten after every command
+        cv.Optional(CONF_FILE, default="gree_ac_trace.json"): cv.string,
+    }
+)
+
+# layouts of 0x33 / 0x44 are not documented, so each sensor names its own byte
+TELEMETRY_SCHEMA = sensor.sensor_schema(
+    accuracy_decimals=1,
+    state_class=STATE_CLASS_MEASUREMENT,
+    entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+).extend(
+    {
+        cv.Required(CONF_COMMAND): cv.one_of(0x33, 0x44, int=True),
+        cv.Required(CONF_BYTE): cv.int_range(min=0, max=44),
+        cv.Optional(CONF_MASK, default=0xFF): cv.uint8_t,
+        cv.Optional(CONF_MULTIPLIER, default=1.0): cv.float_,
+        cv.Optional(CONF_OFFSET, default=0.0): cv.float_,
+        cv.Optional(CONF_SAMPLING_INTERVAL, default="10s"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_PUBLISH_INTERVAL, default="60s"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_DELTA, default=0.5): cv.positive_float,
+    }
+)
+
+# every change of the forwarded value is one SET command, these limit how often that happens
+IFEEL_FORWARDING_SCHEMA = cv.Schema(
+    {
+        cv.Optional(CONF_INTERVAL, default="30s"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_DEADBAND, default=0.5): cv.positive_float,
+    }
+)
+
+# only acts in cool and heat mode, the climate target stays the room target
+LOCAL_CONTROL_SCHEMA = cv.Schema(
+    {
+        cv.Optional(CONF_ALGORITHM, default="hysteresis"): cv.enum(LOCAL_CONTROL_ALGORITHMS, lower=True),
+        cv.Optional(CONF_OUTPUT, default="setpoint"): cv.enum(LOCAL_CONTROL_OUTPUTS, lower=True),
+        cv.Optional(CONF_UPDATE_INTERVAL, default="60s"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_MIN_COMMAND_INTERVAL, default="5min"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_HYSTERESIS, default=0.5): cv.positive_float,
+        cv.Optional(CONF_MAX_OFFSET, default=2.0): cv.float_range(min=1.0, max=7.0),
+        cv.Optional(CONF_KP, default=0.5): cv.positive_float,
+        cv.Optional(CONF_KI, default=0.0005): cv.positive_float,
+    }
+)
 
 SCHEMA = climate.climate_schema(climate.Climate).extend(
     {
@@ -103,24 +412,157 @@ SCHEMA = climate.climate_schema(climate.Climate).extend(
         cv.GenerateID(CONF_IFEEL_SWITCH): cv.declare_id(GreeACSwitch),
         cv.GenerateID(CONF_QUIET_SELECT): cv.declare_id(GreeACSelect),
         cv.Optional(CONF_CURRENT_TEMPERATURE_SENSOR): cv.use_id(sensor.Sensor),
+        cv.Optional(CONF_IFEEL_FORWARDING): IFEEL_FORWARDING_SCHEMA,
+        cv.Optional(CONF_LOCAL_CONTROL): LOCAL_CONTROL_SCHEMA,
+        cv.Optional(CONF_OPTIMISTIC, default=False): cv.boolean,
+        cv.Optional(CONF_PRESETS): cv.ensure_list(PRESET_SCHEMA),
+        cv.Optional(CONF_AUTO_DETECT, default=False): cv.boolean,
+        cv.Optional(CONF_SNIFFER, default=False): cv.boolean,
+        cv.Optional(CONF_FIELD_MAP): FIELD_MAP_SCHEMA,
+        cv.Optional(CONF_TELEMETRY): cv.ensure_list(TELEMETRY_SCHEMA),
+        cv.Optional(CONF_PROTOCOL_COUNTERS): PROTOCOL_COUNTERS_SCHEMA,
+        cv.Optional(CONF_LOOP_PROFILING, default=False): cv.boolean,
+        cv.Optional(CONF_PACKET_CAPTURE): PACKET_CAPTURE_SCHEMA,
+        cv.Optional(CONF_COMMAND_TRACE): COMMAND_TRACE_SCHEMA,
+        cv.Optional(CONF_RUNTIME_STATS): RUNTIME_STATS_SCHEMA,
+        cv.Optional(CONF_HISTORY): HISTORY_SCHEMA,
+        cv.Optional(CONF_RESTORE_STATE, default=False): cv.boolean,
+        cv.Optional(CONF_STATE_SAVE_INTERVAL, default="5min"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_TIME_ID): cv.use_id(time.RealTimeClock),
+        # off by default, the SYNC TIME layout is not confirmed by a capture yet
+        cv.Optional(CONF_SYNC_TIME_INTERVAL, default="0s"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_MAC_REPORT_INTERVAL, default="60min"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_UNIT_BUS_UTILIZATION): sensor.sensor_schema(
+            unit_of_measurement=UNIT_PERCENT,
+            icon="mdi:swap-horizontal",
+            accuracy_decimals=1,
+            state_class=STATE_CLASS_MEASUREMENT,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
+        cv.Optional(CONF_MODULE_BUS_UTILIZATION): sensor.sensor_schema(
+            unit_of_measurement=UNIT_PERCENT,
+            icon="mdi:swap-horizontal",
+            accuracy_decimals=1,
+            state_class=STATE_CLASS_MEASUREMENT,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
+        cv.Optional(CONF_STARTUP_TIME): sensor.sensor_schema(
+            unit_of_measurement=UNIT_MILLISECOND,
+            icon="mdi:timer-outline",
+            accuracy_decimals=0,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
+        cv.Optional(CONF_HEAP_FREE): sensor.sensor_schema(
+            unit_of_measurement=UNIT_BYTES,
+            icon="mdi:memory",
+            accuracy_decimals=0,
+            state_class=STATE_CLASS_MEASUREMENT,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
+        cv.Optional(CONF_HEAP_MIN_FREE): sensor.sensor_schema(
+            unit_of_measurement=UNIT_BYTES,
+            icon="mdi:memory",
+            accuracy_decimals=0,
+            state_class=STATE_CLASS_MEASUREMENT,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
+        cv.Optional(CONF_HEAP_MAX_BLOCK): sensor.sensor_schema(
+            unit_of_measurement=UNIT_BYTES,
+            icon="mdi:memory",
+            accuracy_decimals=0,
+            state_class=STATE_CLASS_MEASUREMENT,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
+        cv.Optional(CONF_STACK_MIN_FREE): sensor.sensor_schema(
+            unit_of_measurement=UNIT_BYTES,
+            icon="mdi:layers-outline",
+            accuracy_decimals=0,
+            state_class=STATE_CLASS_MEASUREMENT,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
+        cv.Optional(CONF_LINK_QUALITY): sensor.sensor_schema(
+            unit_of_measurement=UNIT_PERCENT,
+            icon="mdi:lan-connect",
+            accuracy_decimals=0,
+            state_class=STATE_CLASS_MEASUREMENT,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
+        cv.Optional(CONF_STOCK_COMMAND_INTERVAL): sensor.sensor_schema(
+            unit_of_measurement=UNIT_MILLISECOND,
+            icon="mdi:timer-outline",
+            accuracy_decimals=0,
+            state_class=STATE_CLASS_MEASUREMENT,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
+        cv.Optional(CONF_STOCK_RESPONSE_LATENCY): sensor.sensor_schema(
+            unit_of_measurement=UNIT_MILLISECOND,
+            icon="mdi:timer-outline",
+            accuracy_decimals=0,
+            state_class=STATE_CLASS_MEASUREMENT,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
+        cv.Optional(CONF_FLASH_WRITES): sensor.sensor_schema(
+            icon="mdi:content-save",
+            accuracy_decimals=0,
+            state_class=STATE_CLASS_TOTAL_INCREASING,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
     }
 ).extend(uart.UART_DEVICE_SCHEMA)
 
+def validate_external_sensor(config):
+    for key in (CONF_IFEEL_FORWARDING, CONF_LOCAL_CONTROL):
+        if key in config and CONF_CURRENT_TEMPERATURE_SENSOR not in config:
+            raise cv.Invalid(f"{key} needs {CONF_CURRENT_TEMPERATURE_SENSOR}")
+    # no capture has shown where the SET frame carries the room temperature yet
+    if CONF_IFEEL_FORWARDING in config and "set_ifeel_temp_byte" not in config.get(CONF_FIELD_MAP, {}):
+        raise cv.Invalid(f"{CONF_IFEEL_FORWARDING} needs set_ifeel_temp_byte in {CONF_FIELD_MAP}")
+    return config
+
+
 CONFIG_SCHEMA = cv.All(
     SCHEMA.extend(
         {
             cv.GenerateID(): cv.declare_id(GreeACCNT),
         }
     ),
+    validate_external_sensor,
 )
 
 
+def final_validate_field_map(config):
+    """field_map is compiled into the build, so all instances have to agree on it"""
+    maps = [
+        conf.get(CONF_FIELD_MAP, {})
+        for conf in fv.full_config.get().get("climate", [])
+        if conf.get(CONF_PLATFORM) in ("gree_ac", "sinclair_asc18")
+    ]
+    if any(field_map != maps[0] for field_map in maps):
+        raise cv.Invalid(
+            f"All {CONF_FIELD_MAP} settings of gree_ac and sinclair_asc18 climates have to be the same"
+        )
+    return config
+
+
+FINAL_VALIDATE_SCHEMA = final_validate_field_map
+
+
 async def to_code(config):
     var = cg.new_Pvariable(config[CONF_ID])
     await climate.register_climate(var, config)
     await cg.register_component(var, config)
     await uart.register_uart_device(var, config)
 
+    if field_map := config.get(CONF_FIELD_MAP):
+        # compiled into constexpr protocol constants, the same for all instances in the build
+        entries = ", ".join(f'{{"{name.upper()}", {value}}}' for name, value in field_map.items())
+        cg.add_define("USE_GREE_AC_FIELD_MAP")
+        cg.add_define("GREE_AC_FIELD_MAP", cg.RawExpression("{" + entries + "}"))
+
+    if config[CONF_LOOP_PROFILING]:
+        # micros() histograms per loop phase, logged with dump_config and once a minute
+        cg.add_define("USE_GREE_AC_PROFILING")
+
     selects = [
         (
             CONF_HORIZONTAL_SWING_SELECT,
@@ -189,3 +631,143 @@ async def to_code(config):
     if CONF_CURRENT_TEMPERATURE_SENSOR in config:
         sens = await cg.get_variable(config[CONF_CURRENT_TEMPERATURE_SENSOR])
         cg.add(var.set_current_temperature_sensor(sens))
+    if ifeel_conf := config.get(CONF_IFEEL_FORWARDING):
+        cg.add(var.set_ifeel_forwarding(ifeel_conf[CONF_INTERVAL], ifeel_conf[CONF_DEADBAND]))
+    if control_conf := config.get(CONF_LOCAL_CONTROL):
+        cg.add(
+            var.set_local_control(
+                control_conf[CONF_ALGORITHM],
+                control_conf[CONF_OUTPUT],
+                control_conf[CONF_UPDATE_INTERVAL],
+                control_conf[CONF_MIN_COMMAND_INTERVAL],
+                control_conf[CONF_HYSTERESIS],
+                control_conf[CONF_MAX_OFFSET],
+                control_conf[CONF_KP],
+                control_conf[CONF_KI],
+            )
+        )
+
+    if CONF_TIME_ID in config:
+        time_var = await cg.get_variable(config[CONF_TIME_ID])
+        cg.add(var.set_time(time_var))
+    cg.add(var.set_optimistic(config[CONF_OPTIMISTIC]))
+    cg.add(var.set_auto_detect(config[CONF_AUTO_DETECT]))
+    cg.add(var.set_sniffer(config[CONF_SNIFFER]))
+    cg.add(var.set_restore_state(config[CONF_RESTORE_STATE]))
+    cg.add(var.set_state_save_interval(config[CONF_STATE_SAVE_INTERVAL]))
+    cg.add(var.set_sync_time_interval(config[CONF_SYNC_TIME_INTERVAL]))
+    cg.add(var.set_mac_report_interval(config[CONF_MAC_REPORT_INTERVAL]))
+
+    if CONF_UNIT_BUS_UTILIZATION in config:
+        sens = await sensor.new_sensor(config[CONF_UNIT_BUS_UTILIZATION])
+        cg.add(var.set_unit_bus_utilization_sensor(sens))
+    if CONF_MODULE_BUS_UTILIZATION in config:
+        sens = await sensor.new_sensor(config[CONF_MODULE_BUS_UTILIZATION])
+        cg.add(var.set_module_bus_utilization_sensor(sens))
+    if CONF_STARTUP_TIME in config:
+        sens = await sensor.new_sensor(config[CONF_STARTUP_TIME])
+        cg.add(var.set_startup_time_sensor(sens))
+    if CONF_HEAP_FREE in config:
+        sens = await sensor.new_sensor(config[CONF_HEAP_FREE])
+        cg.add(var.set_heap_free_sensor(sens))
+    if CONF_HEAP_MIN_FREE in config:
+        sens = await sensor.new_sensor(config[CONF_HEAP_MIN_FREE])
+        cg.add(var.set_heap_min_free_sensor(sens))
+    if CONF_HEAP_MAX_BLOCK in config:
+        sens = await sensor.new_sensor(config[CONF_HEAP_MAX_BLOCK])
+        cg.add(var.set_heap_max_block_sensor(sens))
+    if CONF_STACK_MIN_FREE in config:
+        sens = await sensor.new_sensor(config[CONF_STACK_MIN_FREE])
+        cg.add(var.set_stack_min_free_sensor(sens))
+    if CONF_LINK_QUALITY in config:
+        sens = await sensor.new_sensor(config[CONF_LINK_QUALITY])
+        cg.add(var.set_link_quality_sensor(sens))
+    if CONF_STOCK_COMMAND_INTERVAL in config:
+        sens = await sensor.new_sensor(config[CONF_STOCK_COMMAND_INTERVAL])
+        cg.add(var.set_stock_command_interval_sensor(sens))
+    if CONF_STOCK_RESPONSE_LATENCY in config:
+        sens = await sensor.new_sensor(config[CONF_STOCK_RESPONSE_LATENCY])
+        cg.add(var.set_stock_response_latency_sensor(sens))
+    if CONF_FLASH_WRITES in config:
+        sens = await sensor.new_sensor(config[CONF_FLASH_WRITES])
+        cg.add(var.set_flash_writes_sensor(sens))
+
+    counters_conf = config.get(CONF_PROTOCOL_COUNTERS, {})
+    for key, counter in PROTOCOL_COUNTERS.items():
+        if key in counters_conf:
+            sens = await sensor.new_sensor(counters_conf[key])
+            cg.add(var.set_counter_sensor(counter, sens))
+        if key + "_rate" in counters_conf:
+            sens = await sensor.new_sensor(counters_conf[key + "_rate"])
+            cg.add(var.set_counter_rate_sensor(counter, sens))
+
+    if runtime_conf := config.get(CONF_RUNTIME_STATS):
+        cg.add(var.set_runtime_reset_interval(runtime_conf[CONF_RESET_INTERVAL]))
+        for key, stat in RUNTIME_STATS.items():
+            if key in runtime_conf:
+                sens = await sensor.new_sensor(runtime_conf[key])
+                cg.add(var.set_runtime_sensor(stat, sens))
+        if CONF_CYCLES in runtime_conf:
+            sens = await sensor.new_sensor(runtime_conf[CONF_CYCLES])
+            cg.add(var.set_runtime_sensor(gree_ac_ns.RUNTIME_CYCLES, sens))
+
+    if history_conf := config.get(CONF_HISTORY):
+        cg.add(var.set_history_size(history_conf[CONF_SIZE]))
+        if CONF_DUMP_BUTTON in history_conf:
+            btn = await button.new_button(history_conf[CONF_DUMP_BUTTON])
+            await cg.register_parented(btn, var)
+
+    if capture_conf := config.get(CONF_PACKET_CAPTURE):
+        cg.add(var.set_capture_depth(capture_conf[CONF_DEPTH]))
+        if CONF_DUMP_BUTTON in capture_conf:
+            btn = await button.new_button(capture_conf[CONF_DUMP_BUTTON])
+            await cg.register_parented(btn, var)
+
+    if trace_conf := config.get(CONF_COMMAND_TRACE):
+        cg.add_define("USE_GREE_AC_TRACE")
+        cg.add(var.set_trace_depth(trace_conf[CONF_DEPTH]))
+        cg.add(var.set_trace_file(trace_conf[CONF_FILE]))
+        if CONF_DUMP_BUTTON in trace_conf:
+            btn = await button.new_button(trace_conf[CONF_DUMP_BUTTON])
+            await cg.register_parented(btn, var)
+
+    for telemetry_conf in config.get(CONF_TELEMETRY, []):
+        sens = await sensor.new_sensor(telemetry_conf)
+        cg.add(
+            var.add_telemetry(
+                sens,
+                telemetry_conf[CONF_COMMAND],
+                telemetry_conf[CONF_BYTE],
+                telemetry_conf[CONF_MASK],
+                telemetry_conf[CONF_MULTIPLIER],
+                telemetry_conf[CONF_OFFSET],
+                telemetry_conf[CONF_SAMPLING_INTERVAL],
+                telemetry_conf[CONF_PUBLISH_INTERVAL],
+                telemetry_conf[CONF_DELTA],
+            )
+        )
+
+    for preset_conf in config.get(CONF_PRESETS, []):
+        preset = cg.new_Pvariable(preset_conf[CONF_ID])
+        name = preset_conf[CONF_NAME]
+        if name.upper() in climate.CLIMATE_PRESETS:
+            cg.add(preset.set_preset(climate.CLIMATE_PRESETS[name.upper()]))
+        else:
+            cg.add(preset.set_custom_preset(name))
+        for conf_key, setter in (
+            (CONF_MODE, "set_mode"),
+            (CONF_TARGET_TEMPERATURE, "set_target_temperature"),
+            (CONF_FAN_MODE, "set_fan_mode"),
+            (CONF_VERTICAL_SWING, "set_vertical_swing"),
+            (CONF_HORIZONTAL_SWING, "set_horizontal_swing"),
+            (CONF_QUIET, "set_quiet"),
+            (CONF_LIGHT, "set_light"),
+            (CONF_IONIZER, "set_ionizer"),
+            (CONF_SLEEP, "set_sleep"),
+            (CONF_XFAN, "set_xfan"),
+            (CONF_POWERSAVE, "set_powersave"),
+            (CONF_TURBO, "set_turbo"),
+        ):
+            if conf_key in preset_conf:
+                cg.add(getattr(preset, setter)(preset_conf[conf_key]))
+        cg.add(var.add_preset(preset))
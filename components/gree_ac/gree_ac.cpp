@@ -1,8 +1,24 @@
 // based on: https://github.com/DomiStyle/esphome-panasonic-ac
 #include "gree_ac.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstring>
 
 #include "esphome/core/log.h"
 
+#ifdef USE_HOST
+#include <cstdio>
+#endif
+#ifdef USE_ESP8266
+#include <Esp.h>
+#endif
+#ifdef USE_ESP32
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#endif
+
 namespace esphome {
 namespace gree_ac {
 
@@ -16,6 +32,12 @@ const float GreeAC::TEMPERATURE_STEP = 1.0;
 const float GreeAC::TEMPERATURE_TOLERANCE = 2;
 const uint8_t GreeAC::TEMPERATURE_THRESHOLD = 100;
 const uint8_t GreeAC::DATA_MAX = 200;
+const uint32_t GreeAC::BUS_STATS_PERIOD = 60000;
+const uint32_t GreeAC::HISTORY_PERIOD = 60000;
+const uint8_t GreeAC::HISTORY_DUMP_LINES = 10;  /* per loop iteration, a full dump must not block the loop */
+const uint8_t GreeAC::CAPTURE_DUMP_LINES = 4;   /* per loop iteration, a frame line is up to ~200 characters */
+const uint8_t GreeAC::LOG_BURST = 10;
+const uint32_t GreeAC::LOG_REFILL_PERIOD = 1000;
 
 climate::ClimateTraits GreeAC::traits()
 {
@@ -33,6 +55,20 @@ climate::ClimateTraits GreeAC::traits()
                                            fan_modes::FAN_LOW, fan_modes::FAN_MED,
                                            fan_modes::FAN_HIGH, fan_modes::FAN_MAX});
 
+    if (!this->presets_.empty())
+    {
+        std::vector<const char *> custom_presets;
+        traits.add_supported_preset(climate::CLIMATE_PRESET_NONE);
+        for (auto *preset : this->presets_)
+        {
+            if (preset->custom_preset.empty())
+                traits.add_supported_preset(preset->preset);
+            else
+                custom_presets.push_back(preset->custom_preset.c_str());
+        }
+        traits.set_supported_custom_presets(custom_presets);
+    }
+
     return traits;
 }
 
@@ -44,6 +80,12 @@ void GreeAC::setup()
     this->serialProcess_.state = STATE_WAIT_SYNC;
     this->serialProcess_.last_byte_time = millis();
     this->serialProcess_.data.reserve(DATA_MAX);
+    this->last_bus_stats_ = millis();
+
+    this->memory_.min_free = UINT32_MAX;
+    this->memory_.min_block = UINT32_MAX;
+    this->memory_.min_stack = UINT32_MAX;
+    this->sample_memory();
 
     ESP_LOGI(TAG, "Gree AC component v%s starting...", VERSION);
 }
@@ -51,14 +93,52 @@ void GreeAC::setup()
 void GreeAC::dump_config() {
     LOG_CLIMATE("", "Gree AC", this);
     ESP_LOGCONFIG(TAG, "  Component Version: %s", VERSION);
+    LOG_SENSOR("  ", "Unit Bus Utilization", this->unit_bus_utilization_sensor_);
+    LOG_SENSOR("  ", "Module Bus Utilization", this->module_bus_utilization_sensor_);
+    LOG_SENSOR("  ", "Startup Time", this->startup_time_sensor_);
+    LOG_SENSOR("  ", "Heap Free", this->heap_free_sensor_);
+    LOG_SENSOR("  ", "Heap Min Free", this->heap_min_free_sensor_);
+    LOG_SENSOR("  ", "Heap Max Block", this->heap_max_block_sensor_);
+    LOG_SENSOR("  ", "Stack Min Free", this->stack_min_free_sensor_);
+    for (uint8_t i = 0; i < RUNTIME_COUNT; i++)
+    {
+        LOG_SENSOR("  ", "Runtime", this->runtime_sensors_[i]);
+    }
+    if (!this->capture_.empty())
+    {
+        ESP_LOGCONFIG(TAG, "  Packet Capture Depth: %u", (unsigned)this->capture_.size());
+    }
+    if (!this->history_.empty())
+    {
+        ESP_LOGCONFIG(TAG, "  History Size: %u bytes", (unsigned)this->history_.size());
+    }
+#ifdef USE_GREE_AC_TRACE
+    ESP_LOGCONFIG(TAG, "  Command Trace Depth: %u", (unsigned)this->trace_.size());
+#endif
+    for (uint8_t i = 0; i < COUNTER_COUNT; i++)
+    {
+        LOG_SENSOR("  ", "Protocol Counter", this->counter_sensors_[i]);
+        LOG_SENSOR("  ", "Protocol Counter Rate", this->counter_rate_sensors_[i]);
+    }
+#ifdef USE_GREE_AC_PROFILING
+    profile_dump();
+#endif
 }
 
 void GreeAC::loop()
 {
     read_data();  // Read data from UART (if there is any)
+    update_bus_stats();
+    update_history();
+    if (this->capture_dump_left_ > 0)
+    {
+        capture_dump_step();
+    }
 }
 
 void GreeAC::read_data() {
+  GREE_AC_PROFILE(PHASE_READ);
+
   // Check for timeout of partially received packet
   if (this->serialProcess_.state != STATE_WAIT_SYNC &&
       this->serialProcess_.state != STATE_COMPLETE &&
@@ -66,6 +146,7 @@ void GreeAC::read_data() {
       millis() - this->serialProcess_.last_byte_time > READ_TIMEOUT) {
     ESP_LOGV(TAG, "Packet reception timeout (state=%d, bytes=%zu), resetting state machine",
              (int)this->serialProcess_.state, this->serialProcess_.data.size());
+    this->counters_[COUNTER_RECEPTION_TIMEOUTS]++;
     this->serialProcess_.state = STATE_RESTART;
   }
 
@@ -80,6 +161,11 @@ void GreeAC::read_data() {
       break;
     }
     this->serialProcess_.last_byte_time = millis();
+    this->rx_bytes_++;
+
+    if (this->detecting_) {
+      detect_type_c(c);
+    }
 
     if (this->serialProcess_.state == STATE_RESTART) {
       this->serialProcess_.data.clear();
@@ -90,6 +176,9 @@ void GreeAC::read_data() {
       case STATE_WAIT_SYNC:
         if (c == 0x7E) {
           if (this->serialProcess_.data.size() < 2) {
+            if (this->serialProcess_.data.empty()) {
+              this->serialProcess_.first_byte_time = this->serialProcess_.last_byte_time;
+            }
             this->serialProcess_.data.push_back(c);
           }
         } else {
@@ -110,6 +199,8 @@ void GreeAC::read_data() {
         if (this->serialProcess_.data.size() >= (size_t)(this->serialProcess_.frame_size + 3)) {
           /* WE HAVE A FULL FRAME FROM AC */
           this->serialProcess_.state = STATE_COMPLETE;
+          this->counters_[COUNTER_FRAMES_RECEIVED]++;
+          this->sample_memory();
         }
         break;
 
@@ -119,12 +210,113 @@ void GreeAC::read_data() {
 
     if (this->serialProcess_.data.size() >= DATA_MAX) {
       ESP_LOGW(TAG, "Buffer overflow, resetting state machine");
+      this->counters_[COUNTER_OVERFLOWS]++;
       this->serialProcess_.data.clear();
       this->serialProcess_.state = STATE_WAIT_SYNC;
     }
   }
 }
 
+static uint16_t crc16_modbus(uint16_t crc, uint8_t c) {
+  crc ^= c;
+  for (uint8_t i = 0; i < 8; i++) {
+    crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+  }
+  return crc;
+}
+
+/*
+ * Sinclair Type-C frames: 7E xx 82/83/8F, fixed length per command, CRC-16/MODBUS (little endian) at the end.
+ * Only complete frames with a valid CRC count, anything else starts over - a stray 7E in Gree traffic must not.
+ */
+void GreeAC::detect_type_c(uint8_t c) {
+  this->rx_window_ = (this->rx_window_ << 8) | c;
+
+  if (this->type_c_len_ == 0) {
+    if ((this->rx_window_ & 0xFF0000) != 0x7E0000) {
+      return;
+    }
+    switch (c) {
+      case 0x82: this->type_c_len_ = 59; break;
+      case 0x83: this->type_c_len_ = 134; break;
+      case 0x8F: this->type_c_len_ = 133; break;
+      default: return;
+    }
+    this->type_c_crc_ = 0xFFFF;
+    for (int8_t shift = 16; shift >= 0; shift -= 8) {
+      this->type_c_crc_ = crc16_modbus(this->type_c_crc_, (uint8_t) (this->rx_window_ >> shift));
+    }
+    this->type_c_rx_crc_ = 0;
+    this->type_c_pos_ = 3;
+    return;
+  }
+
+  if (this->type_c_pos_ < this->type_c_len_ - 2) {
+    this->type_c_crc_ = crc16_modbus(this->type_c_crc_, c);
+  } else {
+    this->type_c_rx_crc_ |= (uint16_t) c << (8 * (this->type_c_pos_ - (this->type_c_len_ - 2)));
+  }
+  if (++this->type_c_pos_ < this->type_c_len_) {
+    return;
+  }
+
+  this->type_c_len_ = 0;
+  if (this->type_c_crc_ != this->type_c_rx_crc_) {
+    this->type_c_frames_ = 0;
+  } else if (this->type_c_frames_ < UINT8_MAX) {
+    this->type_c_frames_++;
+  }
+}
+
+/* time needed to put len bytes on the wire with current UART settings [ms], rounded up */
+uint32_t GreeAC::frame_air_time(size_t len)
+{
+    uint32_t baud_rate = this->parent_->get_baud_rate();
+    uint32_t bits = 1 + this->parent_->get_data_bits() + this->parent_->get_stop_bits();
+    if (this->parent_->get_parity() != uart::UART_CONFIG_PARITY_NONE)
+    {
+        bits++;
+    }
+
+    if (baud_rate == 0)
+    {
+        return 0;
+    }
+    return ((uint64_t)len * bits * 1000 + baud_rate - 1) / baud_rate;
+}
+
+/* publish share of air time used by each side over the last period */
+void GreeAC::update_bus_stats()
+{
+    uint32_t elapsed = millis() - this->last_bus_stats_;
+    if (elapsed < BUS_STATS_PERIOD)
+    {
+        return;
+    }
+
+    if (this->unit_bus_utilization_sensor_ != nullptr)
+    {
+        this->unit_bus_utilization_sensor_->publish_state(100.0f * frame_air_time(this->rx_bytes_) / elapsed);
+    }
+    if (this->module_bus_utilization_sensor_ != nullptr)
+    {
+        this->module_bus_utilization_sensor_->publish_state(100.0f * frame_air_time(this->tx_bytes_) / elapsed);
+    }
+    publish_counters(elapsed);
+    publish_memory();
+    publish_runtime();
+    log_flush(this->rx_log_);
+    log_flush(this->tx_log_);
+    log_flush(this->state_log_);
+#ifdef USE_GREE_AC_PROFILING
+    profile_dump();
+#endif
+
+    this->rx_bytes_ = 0;
+    this->tx_bytes_ = 0;
+    this->last_bus_stats_ = millis();
+}
+
 void GreeAC::update_current_temperature(float temperature)
 {
     if (temperature > TEMPERATURE_THRESHOLD) {
@@ -148,6 +340,7 @@ void GreeAC::update_target_temperature(float temperature)
 void GreeAC::update_swing_horizontal(const std::string &swing)
 {
     this->horizontal_swing_state_ = swing;
+    this->sample_memory();
 
     if (this->horizontal_swing_select_ != nullptr &&
         this->horizontal_swing_select_->current_option() != this->horizontal_swing_state_)
@@ -159,6 +352,7 @@ void GreeAC::update_swing_horizontal(const std::string &swing)
 void GreeAC::update_swing_vertical(const std::string &swing)
 {
     this->vertical_swing_state_ = swing;
+    this->sample_memory();
 
     if (this->vertical_swing_select_ != nullptr && 
         this->vertical_swing_select_->current_option() != this->vertical_swing_state_)
@@ -170,6 +364,7 @@ void GreeAC::update_swing_vertical(const std::string &swing)
 void GreeAC::update_display(const std::string &display)
 {
     this->display_state_ = display;
+    this->sample_memory();
 
     if (this->display_select_ != nullptr && 
         this->display_select_->current_option() != this->display_state_)
@@ -181,6 +376,7 @@ void GreeAC::update_display(const std::string &display)
 void GreeAC::update_display_unit(const std::string &display_unit)
 {
     this->display_unit_state_ = display_unit;
+    this->sample_memory();
 
     if (this->display_unit_select_ != nullptr && 
         this->display_unit_select_->current_option() != this->display_unit_state_)
@@ -272,6 +468,7 @@ void GreeAC::update_ifeel(bool ifeel)
 void GreeAC::update_quiet(const std::string &quiet)
 {
     this->quiet_state_ = quiet;
+    this->sample_memory();
 
     if (this->quiet_select_ != nullptr &&
         this->quiet_select_->current_option() != this->quiet_state_)
@@ -300,165 +497,547 @@ climate::ClimateAction GreeAC::determine_action()
 }
 
 /*
- * Sensor handling
+ * Presets
  */
 
-void GreeAC::set_current_temperature_sensor(sensor::Sensor *current_temperature_sensor)
+void GreeACPreset::set_fan_mode(const std::string &fan_mode)
 {
-    this->current_temperature_sensor_ = current_temperature_sensor;
-    this->current_temperature_sensor_->add_on_state_callback([this](float state)
+    /* keep pointer to the same constant as used by traits, fan modes are compared that way */
+    for (const char *mode : {fan_modes::FAN_AUTO, fan_modes::FAN_MIN, fan_modes::FAN_LOW,
+                             fan_modes::FAN_MED, fan_modes::FAN_HIGH, fan_modes::FAN_MAX})
+    {
+        if (fan_mode == mode)
         {
-            this->current_temperature = state;
-            this->publish_state();
-        });
+            this->fan_mode = mode;
+            return;
+        }
+    }
+    ESP_LOGW(TAG, "Unknown preset fan mode: %s", fan_mode.c_str());
 }
 
-void GreeAC::set_vertical_swing_select(select::Select *vertical_swing_select)
+const GreeACPreset *GreeAC::find_preset(const climate::ClimateCall &call)
 {
-    this->vertical_swing_select_ = vertical_swing_select;
-    this->vertical_swing_select_->add_on_state_callback([this](size_t index) {
-        auto value = this->vertical_swing_select_->at(index);
-        if (!value.has_value() || *value == this->vertical_swing_state_)
-            return;
-        this->on_vertical_swing_change(*value);
-    });
+    for (auto *preset : this->presets_)
+    {
+        if (call.has_custom_preset())
+        {
+            if (!preset->custom_preset.empty() && preset->custom_preset == call.get_custom_preset())
+                return preset;
+        }
+        else if (call.get_preset().has_value() && preset->custom_preset.empty() && preset->preset == *call.get_preset())
+        {
+            return preset;
+        }
+    }
+    return nullptr;
 }
 
-void GreeAC::set_horizontal_swing_select(select::Select *horizontal_swing_select)
+/* publish protocol health totals and their rate over the last period */
+void GreeAC::publish_counters(uint32_t elapsed)
 {
-    this->horizontal_swing_select_ = horizontal_swing_select;
-    this->horizontal_swing_select_->add_on_state_callback([this](size_t index) {
-        auto value = this->horizontal_swing_select_->at(index);
-        if (!value.has_value() || *value == this->horizontal_swing_state_)
-            return;
-        this->on_horizontal_swing_change(*value);
-    });
+    for (uint8_t i = 0; i < COUNTER_COUNT; i++)
+    {
+        if (this->counter_sensors_[i] != nullptr)
+        {
+            this->counter_sensors_[i]->publish_state(this->counters_[i]);
+        }
+        if (this->counter_rate_sensors_[i] != nullptr)
+        {
+            this->counter_rate_sensors_[i]->publish_state(60000.0f * (this->counters_[i] - this->counters_published_[i]) / elapsed);
+        }
+        this->counters_published_[i] = this->counters_[i];
+    }
 }
 
-void GreeAC::set_display_select(select::Select *display_select)
+/*
+ * Runtime aggregates - whole seconds go to the state seen at the previous report
+ * max_gap: longer silence of the unit is not attributed to anything
+ */
+
+void GreeAC::update_runtime(uint32_t max_gap)
 {
-    this->display_select_ = display_select;
-    this->display_select_->add_on_state_callback([this](size_t index) {
-        auto value = this->display_select_->at(index);
-        if (!value.has_value() || *value == this->display_state_)
-            return;
-        this->on_display_change(*value);
-    });
+    uint8_t mode_slot = RUNTIME_COUNT;
+    switch (this->mode)
+    {
+        case climate::CLIMATE_MODE_AUTO:     mode_slot = RUNTIME_AUTO; break;
+        case climate::CLIMATE_MODE_COOL:     mode_slot = RUNTIME_COOL; break;
+        case climate::CLIMATE_MODE_HEAT:     mode_slot = RUNTIME_HEAT; break;
+        case climate::CLIMATE_MODE_DRY:      mode_slot = RUNTIME_DRY; break;
+        case climate::CLIMATE_MODE_FAN_ONLY: mode_slot = RUNTIME_FAN_ONLY; break;
+        default: break;
+    }
+
+    uint8_t band_slot = RUNTIME_COUNT;
+    if (mode_slot != RUNTIME_COUNT && !std::isnan(this->current_temperature) && !std::isnan(this->target_temperature))
+    {
+        if (this->current_temperature > this->target_temperature + TEMPERATURE_STEP / 2)
+            band_slot = RUNTIME_ABOVE_SETPOINT;
+        else if (this->current_temperature < this->target_temperature - TEMPERATURE_STEP / 2)
+            band_slot = RUNTIME_BELOW_SETPOINT;
+    }
+
+    uint32_t now = millis();
+    if (this->runtime_last_ == 0)
+    {
+        /* first report - nothing to attribute time to yet */
+        this->runtime_last_ = now;
+        this->runtime_window_start_ = now;
+    }
+    else
+    {
+        uint32_t elapsed = now - this->runtime_last_;
+        uint32_t seconds;
+        if (elapsed > max_gap)
+        {
+            seconds = max_gap / 1000;
+            this->runtime_last_ = now;
+        }
+        else
+        {
+            seconds = elapsed / 1000;
+            this->runtime_last_ += seconds * 1000;
+        }
+        if (this->runtime_mode_slot_ != RUNTIME_COUNT)
+            this->runtime_[this->runtime_mode_slot_] += seconds;
+        if (this->runtime_band_slot_ != RUNTIME_COUNT)
+            this->runtime_[this->runtime_band_slot_] += seconds;
+        if (this->runtime_mode_slot_ == RUNTIME_COUNT && mode_slot != RUNTIME_COUNT)
+            this->runtime_[RUNTIME_CYCLES]++;
+    }
+
+    this->runtime_mode_slot_ = mode_slot;
+    this->runtime_band_slot_ = band_slot;
 }
 
-void GreeAC::set_display_unit_select(select::Select *display_unit_select)
+/* publish the running window, a finished window is published once more with its final values before it restarts */
+void GreeAC::publish_runtime()
 {
-    this->display_unit_select_ = display_unit_select;
-    this->display_unit_select_->add_on_state_callback([this](size_t index) {
-        auto value = this->display_unit_select_->at(index);
-        if (!value.has_value() || *value == this->display_unit_state_)
-            return;
-        this->on_display_unit_change(*value);
-    });
+    if (this->runtime_last_ == 0)
+    {
+        return;
+    }
+
+    for (uint8_t i = 0; i < RUNTIME_COUNT; i++)
+    {
+        if (this->runtime_sensors_[i] != nullptr)
+        {
+            this->runtime_sensors_[i]->publish_state(i == RUNTIME_CYCLES ? this->runtime_[i] : this->runtime_[i] / 3600.0f);
+        }
+    }
+
+    if (this->runtime_reset_interval_ > 0 && millis() - this->runtime_window_start_ >= this->runtime_reset_interval_)
+    {
+        memset(this->runtime_, 0, sizeof(this->runtime_));
+        this->runtime_window_start_ = millis();
+    }
 }
 
-void GreeAC::set_light_switch(switch_::Switch *light_switch)
+/*
+ * History - minute samples in a fixed byte ring, the oldest records are dropped into history_base_
+ */
+
+void GreeAC::update_history()
 {
-    this->light_switch_ = light_switch;
-    this->light_switch_->add_on_state_callback([this](bool state) {
-        if (state == this->light_state_)
-            return;
-        this->on_light_change(state);
-    });
+    /* a running dump reads the ring, sampling waits until it is done */
+    if (this->history_dump_left_ > 0)
+    {
+        history_dump_step();
+        return;
+    }
+
+    /* nothing worth keeping before the first reading */
+    if (this->history_.empty() || (this->history_samples_ == 0 && std::isnan(this->current_temperature)))
+    {
+        return;
+    }
+    if (this->history_samples_ > 0 && millis() - this->history_last_ < HISTORY_PERIOD)
+    {
+        return;
+    }
+    this->history_last_ = this->history_samples_ > 0 ? this->history_last_ + HISTORY_PERIOD : millis();
+
+    HistorySample_t sample;
+    if (millis() - this->last_packet_received_ >= HISTORY_PERIOD)
+    {
+        /* the unit did not report for a whole period - what we hold is stale */
+        sample = {HISTORY_GAP_MODE, 0, HISTORY_NO_TEMP};
+    }
+    else
+    {
+        sample.mode = (uint8_t)this->mode & 0x07;
+        sample.target = std::isnan(this->target_temperature) ? 0 : (uint8_t)clamp(lroundf(this->target_temperature * 2), 0L, 254L);
+        sample.current = std::isnan(this->current_temperature) ? HISTORY_NO_TEMP :
+                         (uint8_t)clamp(lroundf(this->current_temperature * 2) + HISTORY_TEMP_OFFSET, 0L, (long)HISTORY_NO_TEMP - 1);
+    }
+
+    /* a delta never crosses HISTORY_NO_TEMP, an unchanged unknown temperature is a zero delta */
+    int delta = (int)sample.current - (int)this->history_prev_.current;
+    bool known = sample.current != HISTORY_NO_TEMP && this->history_prev_.current != HISTORY_NO_TEMP;
+    if (this->history_samples_ > 0 && sample.mode == this->history_prev_.mode && sample.target == this->history_prev_.target &&
+        (known || delta == 0) && delta >= -64 && delta <= 63)
+    {
+        uint8_t record = (uint8_t)delta & 0x7F;
+        history_push(&record, 1);
+    }
+    else
+    {
+        uint8_t record[HISTORY_KEY_FRAME_LEN] = {(uint8_t)(HISTORY_KEY_FRAME | sample.mode), sample.target, sample.current};
+        history_push(record, sizeof(record));
+    }
+    this->history_prev_ = sample;
 }
 
-void GreeAC::set_ionizer_switch(switch_::Switch *ionizer_switch)
+/* apply the record at offset from the tail to sample, returns its length */
+uint8_t GreeAC::history_decode(HistorySample_t &sample, size_t offset) const
 {
-    this->ionizer_switch_ = ionizer_switch;
-    this->ionizer_switch_->add_on_state_callback([this](bool state) {
-        if (state == this->ionizer_state_)
-            return;
-        this->on_ionizer_change(state);
-    });
+    uint8_t head = history_at(offset);
+    if (head & HISTORY_KEY_FRAME)
+    {
+        sample.mode = head & 0x07;
+        sample.target = history_at(offset + 1);
+        sample.current = history_at(offset + 2);
+        return HISTORY_KEY_FRAME_LEN;
+    }
+    /* sign extend the 7 bit delta */
+    sample.current += (int8_t)(head << 1) >> 1;
+    return 1;
 }
 
-void GreeAC::set_beeper_switch(switch_::Switch *beeper_switch)
+void GreeAC::history_push(const uint8_t *record, uint8_t len)
 {
-    this->beeper_switch_ = beeper_switch;
-    this->beeper_switch_->add_on_state_callback([this](bool state) {
-        if (state == this->beeper_state_)
-            return;
-        this->on_beeper_change(state);
-    });
+    size_t size = this->history_.size();
+    while (size - this->history_used_ < len && this->history_used_ > 0)
+    {
+        uint8_t dropped = history_decode(this->history_base_, 0);
+        this->history_tail_ = (this->history_tail_ + dropped) % size;
+        this->history_used_ -= dropped;
+        this->history_samples_--;
+    }
+    for (uint8_t i = 0; i < len; i++)
+    {
+        this->history_[(this->history_tail_ + this->history_used_ + i) % size] = record[i];
+    }
+    this->history_used_ += len;
+    this->history_samples_++;
 }
 
-void GreeAC::set_sleep_switch(switch_::Switch *sleep_switch)
+/* one line per sample, oldest first: minutes before the newest sample, mode, power, setpoint, current temperature */
+void GreeAC::dump_history()
 {
-    this->sleep_switch_ = sleep_switch;
-    this->sleep_switch_->add_on_state_callback([this](bool state) {
-        if (state == this->sleep_state_)
-            return;
-        this->on_sleep_change(state);
-    });
+    ESP_LOGI(TAG, "History: %" PRIu32 " samples in %u of %u bytes, newest %" PRIu32 " s ago", this->history_samples_,
+             (unsigned)this->history_used_, (unsigned)this->history_.size(),
+             this->history_samples_ > 0 ? (millis() - this->history_last_) / 1000 : 0);
+    ESP_LOGI(TAG, "minutes_ago,mode,power,target,current");
+
+    /* the lines follow from loop(), a few at a time */
+    this->history_dump_left_ = this->history_samples_;
+    this->history_dump_offset_ = 0;
+    this->history_dump_sample_ = this->history_base_;
 }
 
-void GreeAC::set_xfan_switch(switch_::Switch *xfan_switch)
+void GreeAC::history_dump_step()
 {
-    this->xfan_switch_ = xfan_switch;
-    this->xfan_switch_->add_on_state_callback([this](bool state) {
-        if (state == this->xfan_state_)
-            return;
-        this->on_xfan_change(state);
-    });
+    HistorySample_t &sample = this->history_dump_sample_;
+    for (uint8_t line = 0; line < HISTORY_DUMP_LINES && this->history_dump_left_ > 0; line++)
+    {
+        this->history_dump_offset_ += history_decode(sample, this->history_dump_offset_);
+        this->history_dump_left_--;
+        climate::ClimateMode mode = (climate::ClimateMode)sample.mode;
+        if (sample.mode == HISTORY_GAP_MODE)
+        {
+            ESP_LOGI(TAG, "%" PRIu32 ",,,,", this->history_dump_left_);
+        }
+        else if (sample.current == HISTORY_NO_TEMP)
+        {
+            ESP_LOGI(TAG, "%" PRIu32 ",%s,%d,%.1f,", this->history_dump_left_, LOG_STR_ARG(climate::climate_mode_to_string(mode)),
+                     mode != climate::CLIMATE_MODE_OFF, sample.target / 2.0f);
+        }
+        else
+        {
+            ESP_LOGI(TAG, "%" PRIu32 ",%s,%d,%.1f,%.1f", this->history_dump_left_, LOG_STR_ARG(climate::climate_mode_to_string(mode)),
+                     mode != climate::CLIMATE_MODE_OFF, sample.target / 2.0f, (sample.current - HISTORY_TEMP_OFFSET) / 2.0f);
+        }
+    }
 }
 
-void GreeAC::set_powersave_switch(switch_::Switch *powersave_switch)
+/*
+ * Memory usage - sampled where frames and option strings grow, reported once per period
+ */
+
+void GreeAC::sample_memory()
 {
-    this->powersave_switch_ = powersave_switch;
-    this->powersave_switch_->add_on_state_callback([this](bool state) {
-        if (state == this->powersave_state_)
-            return;
-        this->on_powersave_change(state);
-    });
+    if (!this->sample_memory_)
+    {
+        return;
+    }
+
+    uint32_t heap = 0, block = 0, stack = 0;
+#if defined(USE_ESP8266)
+    heap = ESP.getFreeHeap();
+    block = ESP.getMaxFreeBlockSize();
+    stack = ESP.getFreeContStack();
+#elif defined(USE_ESP32)
+    heap = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    block = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL);
+    stack = uxTaskGetStackHighWaterMark(nullptr);
+#endif
+    if (heap == 0)
+    {
+        /* no portable way to query the allocator on other platforms */
+        return;
+    }
+
+    this->memory_.free = heap;
+    this->memory_.min_free = std::min(this->memory_.min_free, heap);
+    this->memory_.min_block = std::min(this->memory_.min_block, block);
+    this->memory_.min_stack = std::min(this->memory_.min_stack, stack);
 }
 
-void GreeAC::set_turbo_switch(switch_::Switch *turbo_switch)
+void GreeAC::publish_memory()
 {
-    this->turbo_switch_ = turbo_switch;
-    this->turbo_switch_->add_on_state_callback([this](bool state) {
-        if (state == this->turbo_state_)
-            return;
-        this->on_turbo_change(state);
-    });
+    this->sample_memory();
+    if (this->memory_.free == 0)
+    {
+        return;
+    }
+
+    if (this->heap_free_sensor_ != nullptr)
+    {
+        this->heap_free_sensor_->publish_state(this->memory_.free);
+    }
+    if (this->heap_min_free_sensor_ != nullptr)
+    {
+        this->heap_min_free_sensor_->publish_state(this->memory_.min_free);
+    }
+    if (this->heap_max_block_sensor_ != nullptr)
+    {
+        this->heap_max_block_sensor_->publish_state(this->memory_.min_block);
+    }
+    if (this->stack_min_free_sensor_ != nullptr)
+    {
+        this->stack_min_free_sensor_->publish_state(this->memory_.min_stack);
+    }
 }
 
-void GreeAC::set_ifeel_switch(switch_::Switch *ifeel_switch)
+#ifdef USE_GREE_AC_TRACE
+/*
+ * Command trace - exported in the Chrome trace event format (chrome://tracing, ui.perfetto.dev)
+ */
+
+void GreeAC::trace_record(TracePoint_t point, uint8_t arg)
 {
-    this->ifeel_switch_ = ifeel_switch;
-    this->ifeel_switch_->add_on_state_callback([this](bool state) {
-        if (state == this->ifeel_state_)
-            return;
-        this->on_ifeel_change(state);
-    });
+    if (point != TRACE_COALESCE)
+    {
+        this->trace_stage_ = point;
+    }
+    if (this->trace_.empty())
+    {
+        return;
+    }
+
+    TraceRecord_t &record = this->trace_[this->trace_head_];
+    record.time_us = micros();
+    record.id = this->trace_id_;
+    record.point = point;
+    record.arg = arg;
+    this->trace_head_ = (this->trace_head_ + 1) % this->trace_.size();
+    this->trace_total_++;
+
+#ifdef USE_HOST
+    if (point == TRACE_DONE)
+    {
+        this->dump_trace();
+    }
+#endif
 }
 
-void GreeAC::set_quiet_select(select::Select *quiet_select)
+/* one async span per command - begin at control(), end when done, the steps as instant events in between */
+void GreeAC::dump_trace()
 {
-    this->quiet_select_ = quiet_select;
-    this->quiet_select_->add_on_state_callback([this](size_t index) {
-        auto value = this->quiet_select_->at(index);
-        if (!value.has_value() || *value == this->quiet_state_)
-            return;
-        this->on_quiet_change(*value);
-    });
+    static const char *const POINT_NAMES[TRACE_POINT_COUNT] = {"command", "coalesce", "queued", "wire", "confirm", "publish", "command"};
+
+    size_t depth = this->trace_.size();
+    size_t stored = std::min((size_t)this->trace_total_, depth);
+
+#ifdef USE_HOST
+    FILE *file = fopen(this->trace_file_.c_str(), "w");
+    if (file == nullptr)
+    {
+        ESP_LOGW(TAG, "Cannot write trace to %s", this->trace_file_.c_str());
+        return;
+    }
+    fprintf(file, "{\"traceEvents\":[\n");
+#else
+    ESP_LOGI(TAG, "Command trace, last %u of %" PRIu32 " points (Chrome trace JSON array):", (unsigned)stored, this->trace_total_);
+    ESP_LOGI(TAG, "[");
+#endif
+
+    for (size_t i = 0; i < stored; i++)
+    {
+        const TraceRecord_t &record = this->trace_[(this->trace_head_ + depth - stored + i) % depth];
+        char phase = record.point == TRACE_CONTROL ? 'b' : record.point == TRACE_DONE ? 'e' : 'n';
+        char line[160];
+        snprintf(line, sizeof(line),
+                 "{\"name\":\"%s\",\"cat\":\"gree_ac\",\"ph\":\"%c\",\"id\":%u,\"ts\":%" PRIu32 ",\"pid\":1,\"tid\":1,\"args\":{\"arg\":%u}}%s",
+                 POINT_NAMES[record.point], phase, record.id, record.time_us, record.arg, i + 1 < stored ? "," : "");
+#ifdef USE_HOST
+        fprintf(file, "%s\n", line);
+#else
+        ESP_LOGI(TAG, "%s", line);
+#endif
+    }
+
+#ifdef USE_HOST
+    fprintf(file, "]}\n");
+    fclose(file);
+#else
+    ESP_LOGI(TAG, "]");
+#endif
+}
+#endif
+
+#ifdef USE_GREE_AC_PROFILING
+/*
+ * Loop profiling - fixed power-of-4 buckets, so recording is a few compares
+ */
+
+void GreeAC::profile_record(LoopPhase_t phase, uint32_t us)
+{
+    PhaseHistogram_t &histogram = this->profile_[phase];
+    uint8_t bucket = 0;
+    for (uint32_t limit = 16; bucket < PROFILE_BUCKETS - 1 && us >= limit; limit <<= 2)
+    {
+        bucket++;
+    }
+    histogram.buckets[bucket]++;
+    histogram.count++;
+    histogram.total_us += us;
+    if (us > histogram.max_us)
+    {
+        histogram.max_us = us;
+    }
+}
+
+void GreeAC::profile_dump()
+{
+    static const char *const PHASE_NAMES[PHASE_COUNT] = {"loop", "read", "verify", "decode", "publish", "send"};
+
+    ESP_LOGCONFIG(TAG, "  Loop profile [us] (<16 / <64 / <256 / <1k / <4k / <16k / <65k / more):");
+    for (uint8_t i = 0; i < PHASE_COUNT; i++)
+    {
+        const PhaseHistogram_t &histogram = this->profile_[i];
+        ESP_LOGCONFIG(TAG, "    %-7s n=%" PRIu32 " avg=%" PRIu32 " max=%" PRIu32 " | %" PRIu32 " %" PRIu32 " %" PRIu32 " %" PRIu32 " %" PRIu32 " %" PRIu32 " %" PRIu32 " %" PRIu32,
+                      PHASE_NAMES[i], histogram.count,
+                      histogram.count ? (uint32_t)(histogram.total_us / histogram.count) : 0, histogram.max_us,
+                      histogram.buckets[0], histogram.buckets[1], histogram.buckets[2], histogram.buckets[3],
+                      histogram.buckets[4], histogram.buckets[5], histogram.buckets[6], histogram.buckets[7]);
+    }
+}
+#endif
+
+/*
+ * Sensor handling
+ */
+
+void GreeAC::set_current_temperature_sensor(sensor::Sensor *current_temperature_sensor)
+{
+    this->current_temperature_sensor_ = current_temperature_sensor;
+    this->current_temperature_sensor_->add_on_state_callback([this](float state)
+        {
+            this->current_temperature = state;
+            this->publish_state();
+        });
 }
 
 /*
  * Debugging
  */
 
+/* FNV-1a, only used to spot identical consecutive log lines */
+uint32_t GreeAC::log_hash(const uint8_t *data, size_t len)
+{
+    uint32_t hash = 2166136261UL;
+    for (size_t i = 0; i < len; i++)
+    {
+        hash = (hash ^ data[i]) * 16777619UL;
+    }
+    return hash;
+}
+
+/* true if the line should be printed - identical consecutive lines and lines beyond the burst are counted instead */
+bool GreeAC::log_gate(LogLimiter_t &limiter, uint32_t hash)
+{
+    if (hash == limiter.last_hash)
+    {
+        /* copies of a line the rate limit swallowed are drops as well */
+        if (limiter.last_shown)
+        {
+            limiter.repeats++;
+        }
+        else
+        {
+            limiter.dropped++;
+        }
+        return false;
+    }
+    /* a different line ends the run, report it right here so the count stays next to the line it belongs to */
+    if (limiter.repeats > 0)
+    {
+        ESP_LOGD(TAG, "%s: previous line repeated %" PRIu32 " times", limiter.name, limiter.repeats);
+        limiter.repeats = 0;
+    }
+    limiter.last_hash = hash;
+    limiter.last_shown = false;
+
+    uint32_t now = millis();
+    uint32_t refill = (now - limiter.last_refill) / LOG_REFILL_PERIOD;
+    if (refill > 0)
+    {
+        limiter.tokens = std::min<uint32_t>(LOG_BURST, limiter.tokens + refill);
+        limiter.last_refill = now;
+    }
+    if (limiter.tokens == 0)
+    {
+        limiter.dropped++;
+        return false;
+    }
+    limiter.tokens--;
+    limiter.last_shown = true;
+    return true;
+}
+
+/* summarize the lines the rate limit swallowed, called once per period */
+void GreeAC::log_flush(LogLimiter_t &limiter)
+{
+    if (limiter.dropped == 0)
+    {
+        return;
+    }
+    ESP_LOGD(TAG, "%s: %" PRIu32 " rate limited lines not shown", limiter.name, limiter.dropped);
+    limiter.dropped = 0;
+}
+
 void GreeAC::log_packet(const uint8_t *data, size_t len, bool outgoing)
 {
+    /* a running dump reads the ring, frames seen meanwhile are not kept */
+    if (!this->capture_.empty() && this->capture_dump_left_ == 0)
+    {
+        CaptureEntry_t &entry = this->capture_[this->capture_head_];
+        entry.time_us = micros();
+        entry.len = std::min(len, (size_t)UINT8_MAX);
+        entry.outgoing = outgoing;
+        memcpy(entry.data, data, std::min(len, (size_t)CAPTURE_FRAME_MAX));
+        this->capture_head_ = (this->capture_head_ + 1) % this->capture_.size();
+        this->capture_total_++;
+    }
+
 #if ESPHOME_LOG_LEVEL >= ESPHOME_LOG_LEVEL_VERBOSE
     if (outgoing) {
-        ESP_LOGV(TAG, "TX: %s", format_hex_pretty(data, len).c_str());
+        if (log_gate(this->tx_log_, log_hash(data, len)))
+            ESP_LOGV(TAG, "TX: %s", format_hex_pretty(data, len).c_str());
     } else {
-        ESP_LOGV(TAG, "RX: %s", format_hex_pretty(data, len).c_str());
+        if (log_gate(this->rx_log_, log_hash(data, len)))
+            ESP_LOGV(TAG, "RX: %s", format_hex_pretty(data, len).c_str());
     }
 #endif
 }
@@ -468,5 +1047,34 @@ void GreeAC::log_packet(const std::vector<uint8_t> &data, bool outgoing)
     log_packet(data.data(), data.size(), outgoing);
 }
 
+/* print the capture ring oldest first, timestamps relative to the newest frame */
+void GreeAC::dump_capture()
+{
+    size_t depth = this->capture_.size();
+    size_t stored = std::min((size_t)this->capture_total_, depth);
+    ESP_LOGI(TAG, "Packet capture: last %u of %" PRIu32 " frames", (unsigned)stored, this->capture_total_);
+    if (stored == 0)
+    {
+        return;
+    }
+
+    /* the lines follow from loop(), a few at a time */
+    this->capture_dump_newest_ = this->capture_[(this->capture_head_ + depth - 1) % depth].time_us;
+    this->capture_dump_left_ = stored;
+}
+
+void GreeAC::capture_dump_step()
+{
+    size_t depth = this->capture_.size();
+    for (uint8_t line = 0; line < CAPTURE_DUMP_LINES && this->capture_dump_left_ > 0; line++)
+    {
+        const CaptureEntry_t &entry = this->capture_[(this->capture_head_ + depth - this->capture_dump_left_) % depth];
+        this->capture_dump_left_--;
+        ESP_LOGI(TAG, "  %10" PRId32 " us %s: %s%s", (int32_t)(entry.time_us - this->capture_dump_newest_),
+                 entry.outgoing ? "TX" : "RX", format_hex_pretty(entry.data, std::min(entry.len, CAPTURE_FRAME_MAX)).c_str(),
+                 entry.len > CAPTURE_FRAME_MAX ? " (truncated)" : "");
+    }
+}
+
 }  // namespace gree_ac
 }  // namespace esphome
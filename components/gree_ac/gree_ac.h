@@ -7,12 +7,15 @@
 #include "esphome/components/switch/switch.h"
 #include "esphome/components/uart/uart.h"
 #include "esphome/core/component.h"
+#include "esphome/core/defines.h"
+#include "esphome/core/optional.h"
 
 namespace esphome {
 
 namespace gree_ac {
 
 
+/* climate.py reads the option lists below in declaration order, their strings have to stay plain literals */
 namespace fan_modes{
     const char* const FAN_AUTO  = "Auto";
     const char* const FAN_MIN   = "Minimum";
@@ -22,14 +25,12 @@ namespace fan_modes{
     const char* const FAN_MAX   = "Maximum";
 }
 
-/* this must be same as QUIET_OPTIONS in climate.py */
 namespace quiet_options{
     const char* const OFF   = "Off";
     const char* const ON    = "On";
     const char* const AUTO  = "Auto";
 }
 
-/* this must be same as HORIZONTAL_SWING_OPTIONS in climate.py */
 namespace horizontal_swing_options{
     const char* const OFF    = "Off";
     const char* const FULL   = "Swing - Full";
@@ -40,7 +41,6 @@ namespace horizontal_swing_options{
     const char* const CRIGHT = "Constant - Right";
 }
 
-/* this must be same as VERTICAL_SWING_OPTIONS in climate.py */
 namespace vertical_swing_options{
     const char* const OFF   = "Off";
     const char* const FULL  = "Swing - Full";
@@ -56,18 +56,54 @@ namespace vertical_swing_options{
     const char* const CUP   = "Constant - Up";
 }
 
-/* this must be same as DISPLAY_OPTIONS in climate.py */
 namespace display_options{
     const char* const SET  = "Set temperature";
     const char* const ACT  = "Actual temperature";
 }
 
-/* this must be same as DISPLAY_UNIT_OPTIONS in climate.py */
 namespace display_unit_options{
     const char* const DEGC = "C";
     const char* const DEGF = "F";
 }
 
+/* bundle of settings applied to the unit at once when a climate preset is selected */
+class GreeACPreset {
+    public:
+        void set_preset(climate::ClimatePreset preset) { this->preset = preset; }
+        void set_custom_preset(const std::string &custom_preset) { this->custom_preset = custom_preset; }
+
+        void set_mode(climate::ClimateMode mode) { this->mode = mode; }
+        void set_target_temperature(float target_temperature) { this->target_temperature = target_temperature; }
+        void set_fan_mode(const std::string &fan_mode);
+        void set_vertical_swing(const std::string &vertical_swing) { this->vertical_swing = vertical_swing; }
+        void set_horizontal_swing(const std::string &horizontal_swing) { this->horizontal_swing = horizontal_swing; }
+        void set_quiet(const std::string &quiet) { this->quiet = quiet; }
+
+        void set_light(bool light) { this->light = light; }
+        void set_ionizer(bool ionizer) { this->ionizer = ionizer; }
+        void set_sleep(bool sleep) { this->sleep = sleep; }
+        void set_xfan(bool xfan) { this->xfan = xfan; }
+        void set_powersave(bool powersave) { this->powersave = powersave; }
+        void set_turbo(bool turbo) { this->turbo = turbo; }
+
+        climate::ClimatePreset preset = climate::CLIMATE_PRESET_NONE; /* standard preset, NONE if custom */
+        std::string custom_preset;                                     /* name of custom preset */
+
+        /* fields not set in YAML are left untouched */
+        optional<climate::ClimateMode> mode;
+        optional<float> target_temperature;
+        const char *fan_mode = nullptr; /* one of fan_modes */
+        optional<std::string> vertical_swing;
+        optional<std::string> horizontal_swing;
+        optional<std::string> quiet;
+        optional<bool> light;
+        optional<bool> ionizer;
+        optional<bool> sleep;
+        optional<bool> xfan;
+        optional<bool> powersave;
+        optional<bool> turbo;
+};
+
 typedef enum {
         STATE_WAIT_SYNC,
         STATE_RECIEVE,
@@ -75,38 +111,169 @@ typedef enum {
         STATE_RESTART
 } SerialProcessState_t;
 
+/* protocol health counters, index into GreeAC::counters_ */
+typedef enum {
+        COUNTER_FRAMES_RECEIVED,
+        COUNTER_FRAMES_SENT,
+        COUNTER_CHECKSUM_ERRORS,
+        COUNTER_DISALLOWED_COMMANDS,
+        COUNTER_OVERFLOWS,
+        COUNTER_RECEPTION_TIMEOUTS,
+        COUNTER_RESPONSE_TIMEOUTS,
+        COUNTER_STATE_FLAPS,
+        COUNTER_COUNT
+} ProtocolCounter_t;
+
+/* streaming aggregates over decoded reports, seconds except for RUNTIME_CYCLES */
+typedef enum {
+        RUNTIME_AUTO,
+        RUNTIME_COOL,
+        RUNTIME_HEAT,
+        RUNTIME_DRY,
+        RUNTIME_FAN_ONLY,
+        RUNTIME_ABOVE_SETPOINT,
+        RUNTIME_BELOW_SETPOINT,
+        RUNTIME_CYCLES,          /* off to on transitions */
+        RUNTIME_COUNT
+} RuntimeStat_t;
+
+/* heap and stack low-water marks, taken where the component allocates */
+typedef struct {
+    uint32_t free;       /* free heap at the last sample */
+    uint32_t min_free;   /* lowest free heap seen since boot */
+    uint32_t min_block;  /* smallest largest-free-block seen since boot */
+    uint32_t min_stack;  /* lowest free loop stack seen since boot */
+} MemoryStats_t;
+
+/* repeat collapsing and token bucket for one stream of protocol log lines */
+typedef struct {
+    const char *name;      /* stream prefix of the summary lines */
+    uint32_t last_hash;    /* hash of the last line offered */
+    bool last_shown;       /* the last line was printed, so its repeats are reported when the run ends */
+    uint32_t repeats;      /* copies of the printed last line swallowed so far */
+    uint32_t dropped;      /* lines swallowed by the rate limit since the last summary */
+    uint32_t last_refill;
+    uint8_t tokens;
+} LogLimiter_t;
+
+static const uint8_t CAPTURE_FRAME_MAX = 64; /* longer frames are stored truncated */
+
+/* one frame in the packet capture ring */
+typedef struct {
+    uint32_t time_us;
+    uint8_t len;       /* length on the wire */
+    bool outgoing;
+    uint8_t data[CAPTURE_FRAME_MAX];
+} CaptureEntry_t;
+
+/*
+ * One history sample per minute. A sample that keeps mode and setpoint is one byte, 0ddddddd, holding the
+ * change of current temperature in half degrees. Anything else is a 3 byte key frame:
+ * 1xxxxmmm (climate mode), setpoint, current temperature, both as HistorySample_t stores them.
+ * Minutes without any report from the unit are gap samples, a run of them costs one byte per minute.
+ */
+typedef struct {
+    uint8_t mode;
+    uint8_t target;   /* half degrees */
+    uint8_t current;  /* half degrees + HISTORY_TEMP_OFFSET, HISTORY_NO_TEMP if unknown */
+} HistorySample_t;
+
+static const uint8_t HISTORY_TEMP_OFFSET = 40;  /* current temperature down to -20 degC */
+static const uint8_t HISTORY_NO_TEMP = 0xFF;
+static const uint8_t HISTORY_KEY_FRAME = 0x80;
+static const uint8_t HISTORY_KEY_FRAME_LEN = 3;
+static const uint8_t HISTORY_GAP_MODE = 0x07;   /* no climate mode uses it */
+
+#ifdef USE_GREE_AC_TRACE
+/* steps of one command from control() to the unit and back */
+typedef enum {
+        TRACE_CONTROL,   /* control() opened a new command */
+        TRACE_COALESCE,  /* arg 1: call merged into a command not sent yet */
+        TRACE_QUEUED,    /* SET frame with changes is due */
+        TRACE_WIRE,      /* SET frame handed to the UART */
+        TRACE_CONFIRM,   /* first unit report accepted after the SET frame */
+        TRACE_PUBLISH,   /* arg 1: optimistic publish from control() */
+        TRACE_DONE,      /* command closed, arg 0 if nothing was sent */
+        TRACE_POINT_COUNT
+} TracePoint_t;
+
+typedef struct {
+    uint32_t time_us;
+    uint16_t id;
+    uint8_t point;
+    uint8_t arg;
+} TraceRecord_t;
+#endif
+
+#ifdef USE_GREE_AC_PROFILING
+/* loop phases timed by the profiler */
+typedef enum {
+        PHASE_LOOP,
+        PHASE_READ,
+        PHASE_VERIFY,
+        PHASE_DECODE,
+        PHASE_PUBLISH,
+        PHASE_SEND,
+        PHASE_COUNT
+} LoopPhase_t;
+
+static const uint8_t PROFILE_BUCKETS = 8; /* <16us, <64us, <256us, <1ms, <4ms, <16ms, <65ms, longer */
+
+typedef struct {
+    uint32_t buckets[PROFILE_BUCKETS];
+    uint32_t count;
+    uint32_t max_us;
+    uint64_t total_us;
+} PhaseHistogram_t;
+#endif
+
 typedef struct {
   std::vector<uint8_t> data;
   uint8_t frame_size;
   SerialProcessState_t state;
+  uint32_t first_byte_time;
   uint32_t last_byte_time;
 } SerialProcess_t;
 
 class GreeAC : public Component, public uart::UARTDevice, public climate::Climate {
     public:
-        void set_vertical_swing_select(select::Select *vertical_swing_select);
-        void set_horizontal_swing_select(select::Select *horizontal_swing_select);
+        void set_current_temperature_sensor(sensor::Sensor *current_temperature_sensor);
 
-        void set_display_select(select::Select *display_select);
-        void set_display_unit_select(select::Select *display_unit_select);
+        void add_preset(GreeACPreset *preset) { this->presets_.push_back(preset); }
 
-        void set_light_switch(switch_::Switch *light_switch);
-        void set_ionizer_switch(switch_::Switch *ionizer_switch);
-        void set_beeper_switch(switch_::Switch *beeper_switch);
-        void set_sleep_switch(switch_::Switch *sleep_switch);
-        void set_xfan_switch(switch_::Switch *xfan_switch);
-        void set_powersave_switch(switch_::Switch *powersave_switch);
-        void set_turbo_switch(switch_::Switch *turbo_switch);
-        void set_ifeel_switch(switch_::Switch *ifeel_switch);
-
-        void set_quiet_select(select::Select *quiet_select);
+        void set_unit_bus_utilization_sensor(sensor::Sensor *unit_bus_utilization_sensor) { this->unit_bus_utilization_sensor_ = unit_bus_utilization_sensor; }
+        void set_module_bus_utilization_sensor(sensor::Sensor *module_bus_utilization_sensor) { this->module_bus_utilization_sensor_ = module_bus_utilization_sensor; }
+        void set_startup_time_sensor(sensor::Sensor *startup_time_sensor) { this->startup_time_sensor_ = startup_time_sensor; }
+        void set_counter_sensor(ProtocolCounter_t counter, sensor::Sensor *sensor) { this->counter_sensors_[counter] = sensor; }
+        void set_counter_rate_sensor(ProtocolCounter_t counter, sensor::Sensor *sensor) { this->counter_rate_sensors_[counter] = sensor; }
+        void set_runtime_sensor(RuntimeStat_t stat, sensor::Sensor *sensor) { this->runtime_sensors_[stat] = sensor; }
+        void set_runtime_reset_interval(uint32_t runtime_reset_interval) { this->runtime_reset_interval_ = runtime_reset_interval; }
+        void set_heap_free_sensor(sensor::Sensor *heap_free_sensor) { this->heap_free_sensor_ = heap_free_sensor; this->sample_memory_ = true; }
+        void set_heap_min_free_sensor(sensor::Sensor *heap_min_free_sensor) { this->heap_min_free_sensor_ = heap_min_free_sensor; this->sample_memory_ = true; }
+        void set_heap_max_block_sensor(sensor::Sensor *heap_max_block_sensor) { this->heap_max_block_sensor_ = heap_max_block_sensor; this->sample_memory_ = true; }
+        void set_stack_min_free_sensor(sensor::Sensor *stack_min_free_sensor) { this->stack_min_free_sensor_ = stack_min_free_sensor; this->sample_memory_ = true; }
 
-        void set_current_temperature_sensor(sensor::Sensor *current_temperature_sensor);
+        void set_capture_depth(uint8_t depth) { this->capture_.resize(depth); }
 
         void setup() override;
         void loop() override;
         void dump_config() override;
 
+        void dump_capture();
+
+        void set_history_size(uint16_t size) { this->history_.resize(size); }
+        void dump_history();
+
+#ifdef USE_GREE_AC_TRACE
+        void set_trace_depth(uint8_t depth) { this->trace_.resize(depth); }
+        void set_trace_file(const std::string &trace_file) { this->trace_file_ = trace_file; }
+        void dump_trace();
+#endif
+
+#ifdef USE_GREE_AC_PROFILING
+        void profile_record(LoopPhase_t phase, uint32_t us);
+#endif
+
     protected:
         select::Select *vertical_swing_select_   = nullptr; /* Advanced vertical swing select */
         select::Select *horizontal_swing_select_ = nullptr; /* Advanced horizontal swing select */
@@ -127,6 +294,32 @@ class GreeAC : public Component, public uart::UARTDevice, public climate::Climat
 
         sensor::Sensor *current_temperature_sensor_ = nullptr; /* If user wants to replace reported temperature by an external sensor readout */
 
+        sensor::Sensor *unit_bus_utilization_sensor_   = nullptr; /* Percentage of air time used by the AC unit */
+        sensor::Sensor *module_bus_utilization_sensor_ = nullptr; /* Percentage of air time used by us */
+        sensor::Sensor *startup_time_sensor_           = nullptr; /* Time from power-on to first published state */
+        sensor::Sensor *heap_free_sensor_              = nullptr; /* Free heap at the end of the period */
+        sensor::Sensor *heap_min_free_sensor_          = nullptr; /* Free heap low-water mark since boot */
+        sensor::Sensor *heap_max_block_sensor_         = nullptr; /* Smallest largest-free-block seen since boot */
+        sensor::Sensor *stack_min_free_sensor_         = nullptr; /* Loop task stack high-water mark */
+
+        sensor::Sensor *runtime_sensors_[RUNTIME_COUNT] = {};
+        uint32_t runtime_[RUNTIME_COUNT] = {};
+        uint32_t runtime_reset_interval_ = 0; /* 0 = never reset */
+        uint32_t runtime_window_start_ = 0;
+        uint32_t runtime_last_ = 0;           /* 0 until the first report */
+        uint8_t runtime_mode_slot_ = RUNTIME_COUNT;
+        uint8_t runtime_band_slot_ = RUNTIME_COUNT;
+        void update_runtime(uint32_t max_gap);
+        void publish_runtime();
+
+        bool sample_memory_ = false;
+        MemoryStats_t memory_ = {};
+        void sample_memory();
+        void publish_memory();
+
+        std::vector<GreeACPreset *> presets_;
+        const GreeACPreset *find_preset(const climate::ClimateCall &call);
+
         std::string vertical_swing_state_;
         std::string horizontal_swing_state_;
 
@@ -134,27 +327,52 @@ class GreeAC : public Component, public uart::UARTDevice, public climate::Climat
         std::string display_unit_state_;
         std::string quiet_state_;
 
-        bool light_state_;
-        bool ionizer_state_;
-        bool beeper_state_;
-        bool sleep_state_;
-        bool xfan_state_;
-        bool powersave_state_;
-        bool turbo_state_;
-        bool ifeel_state_;
+        bool light_state_     = false;
+        bool ionizer_state_   = false;
+        bool beeper_state_    = false;
+        bool sleep_state_     = false;
+        bool xfan_state_      = false;
+        bool powersave_state_ = false;
+        bool turbo_state_     = false;
+        bool ifeel_state_     = false;
 
         SerialProcess_t serialProcess_;
 
         uint32_t init_time_;   // Stores the current time
         // uint32_t last_read_;   // Stores the time at which the last read was done
         uint32_t last_packet_sent_;  // Stores the time at which the last packet was sent
-        uint32_t last_03packet_sent_;  // Stores the time at which the last packet was sent
-        uint32_t last_packet_received_;  // Stores the time at which the last packet was received
-        bool wait_response_;
+        uint32_t last_packet_received_ = 0;  // Stores the time at which the last packet was received
+        bool wait_response_ = false;
+
+        uint32_t rx_bytes_ = 0;         /* bytes received since last bus statistics update */
+        uint32_t tx_bytes_ = 0;         /* bytes sent since last bus statistics update */
+        uint32_t last_bus_stats_ = 0;   /* time of last bus statistics update */
+
+        uint32_t counters_[COUNTER_COUNT] = {};                      /* since boot, bumped where the event happens */
+        uint32_t counters_published_[COUNTER_COUNT] = {};            /* values at last publication, for rates */
+        sensor::Sensor *counter_sensors_[COUNTER_COUNT] = {};        /* totals */
+        sensor::Sensor *counter_rate_sensors_[COUNTER_COUNT] = {};   /* events per minute */
+
+#ifdef USE_GREE_AC_PROFILING
+        PhaseHistogram_t profile_[PHASE_COUNT] = {};
+        void profile_dump();
+#endif
+
+        bool detecting_ = false;        /* line settings auto-detection in progress */
+        uint32_t rx_window_ = 0;        /* last bytes received, used while detecting */
+        uint8_t type_c_len_ = 0;        /* length of the Type-C frame being checked, 0 if none */
+        uint8_t type_c_pos_ = 0;
+        uint16_t type_c_crc_ = 0;       /* CRC-16/MODBUS of the bytes received so far */
+        uint16_t type_c_rx_crc_ = 0;    /* CRC carried by the frame */
+        uint8_t type_c_frames_ = 0;     /* consecutive valid Sinclair Type-C frames seen while detecting */
 
         climate::ClimateTraits traits() override;
 
         void read_data();
+        void detect_type_c(uint8_t c);
+        uint32_t frame_air_time(size_t len);
+        void update_bus_stats();
+        void publish_counters(uint32_t elapsed);
 
         void update_current_temperature(float temperature);
         void update_target_temperature(float temperature);
@@ -175,24 +393,48 @@ class GreeAC : public Component, public uart::UARTDevice, public climate::Climat
         void update_ifeel(bool ifeel);
         void update_quiet(const std::string &quiet);
 
-        virtual void on_horizontal_swing_change(const std::string &swing) = 0;
-        virtual void on_vertical_swing_change(const std::string &swing) = 0;
-
-        virtual void on_display_change(const std::string &display) = 0;
-        virtual void on_display_unit_change(const std::string &display_unit) = 0;
-
-        virtual void on_light_change(bool light) = 0;
-        virtual void on_ionizer_change(bool ionizer) = 0;
-        virtual void on_beeper_change(bool beeper) = 0;
-        virtual void on_sleep_change(bool sleep) = 0;
-        virtual void on_xfan_change(bool xfan) = 0;
-        virtual void on_powersave_change(bool powersave) = 0;
-        virtual void on_turbo_change(bool turbo) = 0;
-        virtual void on_ifeel_change(bool ifeel) = 0;
-        virtual void on_quiet_change(const std::string &quiet) = 0;
-
         climate::ClimateAction determine_action();
 
+        std::vector<uint8_t> history_;  /* delta encoded ring of samples, empty when history is off */
+        size_t history_tail_ = 0;       /* oldest record */
+        size_t history_used_ = 0;
+        uint32_t history_samples_ = 0;  /* samples in the ring */
+        uint32_t history_last_ = 0;     /* time of the newest sample */
+        HistorySample_t history_base_ = {}; /* state before the oldest record */
+        HistorySample_t history_prev_ = {}; /* newest sample */
+        uint32_t history_dump_left_ = 0;    /* samples a running dump still has to log */
+        size_t history_dump_offset_ = 0;
+        HistorySample_t history_dump_sample_ = {};
+        void update_history();
+        void history_dump_step();
+        uint8_t history_at(size_t offset) const { return this->history_[(this->history_tail_ + offset) % this->history_.size()]; }
+        uint8_t history_decode(HistorySample_t &sample, size_t offset) const;
+        void history_push(const uint8_t *record, uint8_t len);
+
+        std::vector<CaptureEntry_t> capture_; /* ring of the last frames, empty when capture is off */
+        size_t capture_head_ = 0;
+        uint32_t capture_total_ = 0;
+        size_t capture_dump_left_ = 0;     /* frames a running dump still has to log, the ring is frozen meanwhile */
+        uint32_t capture_dump_newest_ = 0; /* time of the newest frame when the dump started */
+        void capture_dump_step();
+
+#ifdef USE_GREE_AC_TRACE
+        std::vector<TraceRecord_t> trace_; /* ring of command trace points */
+        size_t trace_head_ = 0;
+        uint32_t trace_total_ = 0;
+        uint16_t trace_id_ = 0;
+        uint8_t trace_stage_ = TRACE_DONE; /* last step of the open command */
+        std::string trace_file_;           /* host builds write Chrome trace JSON here */
+        void trace_record(TracePoint_t point, uint8_t arg = 0);
+#endif
+
+        LogLimiter_t rx_log_ = {"RX"};
+        LogLimiter_t tx_log_ = {"TX"};
+        LogLimiter_t state_log_ = {"State"};
+        static uint32_t log_hash(const uint8_t *data, size_t len);
+        bool log_gate(LogLimiter_t &limiter, uint32_t hash);
+        void log_flush(LogLimiter_t &limiter);
+
         void log_packet(const uint8_t *data, size_t len, bool outgoing = false);
         void log_packet(const std::vector<uint8_t> &data, bool outgoing = false);
 
@@ -205,7 +447,204 @@ class GreeAC : public Component, public uart::UARTDevice, public climate::Climat
         static const float TEMPERATURE_TOLERANCE;
         static const uint8_t TEMPERATURE_THRESHOLD;
         static const uint8_t DATA_MAX;
+        static const uint32_t BUS_STATS_PERIOD;
+        static const uint32_t HISTORY_PERIOD;
+        static const uint8_t HISTORY_DUMP_LINES;
+        static const uint8_t CAPTURE_DUMP_LINES;
+        static const uint8_t LOG_BURST;
+        static const uint32_t LOG_REFILL_PERIOD;
 };
 
+
+#ifdef USE_GREE_AC_PROFILING
+/* times the enclosing scope into one histogram of the owning component */
+class PhaseTimer {
+    public:
+        PhaseTimer(GreeAC *parent, LoopPhase_t phase) : parent_(parent), phase_(phase), start_(micros()) {}
+        ~PhaseTimer() { this->parent_->profile_record(this->phase_, micros() - this->start_); }
+
+    protected:
+        GreeAC *parent_;
+        LoopPhase_t phase_;
+        uint32_t start_;
+};
+#define GREE_AC_PROFILE(phase) PhaseTimer phase_timer(this, phase)
+#else
+#define GREE_AC_PROFILE(phase)
+#endif
+
+/*
+ * Static dispatch of entity changes to a protocol variant (CRTP). Derived provides the
+ * on_*_change handlers, calls are resolved and can be inlined at compile time.
+ */
+template<typename Derived>
+class GreeACVariant : public GreeAC {
+    public:
+        void set_vertical_swing_select(select::Select *vertical_swing_select);
+        void set_horizontal_swing_select(select::Select *horizontal_swing_select);
+
+        void set_display_select(select::Select *display_select);
+        void set_display_unit_select(select::Select *display_unit_select);
+
+        void set_light_switch(switch_::Switch *light_switch);
+        void set_ionizer_switch(switch_::Switch *ionizer_switch);
+        void set_beeper_switch(switch_::Switch *beeper_switch);
+        void set_sleep_switch(switch_::Switch *sleep_switch);
+        void set_xfan_switch(switch_::Switch *xfan_switch);
+        void set_powersave_switch(switch_::Switch *powersave_switch);
+        void set_turbo_switch(switch_::Switch *turbo_switch);
+        void set_ifeel_switch(switch_::Switch *ifeel_switch);
+
+        void set_quiet_select(select::Select *quiet_select);
+};
+
+template<typename Derived>
+void GreeACVariant<Derived>::set_vertical_swing_select(select::Select *vertical_swing_select)
+{
+    this->vertical_swing_select_ = vertical_swing_select;
+    this->vertical_swing_select_->add_on_state_callback([this](size_t index) {
+        auto value = this->vertical_swing_select_->at(index);
+        if (!value.has_value() || *value == this->vertical_swing_state_)
+            return;
+        static_cast<Derived *>(this)->on_vertical_swing_change(*value);
+    });
+}
+
+template<typename Derived>
+void GreeACVariant<Derived>::set_horizontal_swing_select(select::Select *horizontal_swing_select)
+{
+    this->horizontal_swing_select_ = horizontal_swing_select;
+    this->horizontal_swing_select_->add_on_state_callback([this](size_t index) {
+        auto value = this->horizontal_swing_select_->at(index);
+        if (!value.has_value() || *value == this->horizontal_swing_state_)
+            return;
+        static_cast<Derived *>(this)->on_horizontal_swing_change(*value);
+    });
+}
+
+template<typename Derived>
+void GreeACVariant<Derived>::set_display_select(select::Select *display_select)
+{
+    this->display_select_ = display_select;
+    this->display_select_->add_on_state_callback([this](size_t index) {
+        auto value = this->display_select_->at(index);
+        if (!value.has_value() || *value == this->display_state_)
+            return;
+        static_cast<Derived *>(this)->on_display_change(*value);
+    });
+}
+
+template<typename Derived>
+void GreeACVariant<Derived>::set_display_unit_select(select::Select *display_unit_select)
+{
+    this->display_unit_select_ = display_unit_select;
+    this->display_unit_select_->add_on_state_callback([this](size_t index) {
+        auto value = this->display_unit_select_->at(index);
+        if (!value.has_value() || *value == this->display_unit_state_)
+            return;
+        static_cast<Derived *>(this)->on_display_unit_change(*value);
+    });
+}
+
+template<typename Derived>
+void GreeACVariant<Derived>::set_light_switch(switch_::Switch *light_switch)
+{
+    this->light_switch_ = light_switch;
+    this->light_switch_->add_on_state_callback([this](bool state) {
+        if (state == this->light_state_)
+            return;
+        static_cast<Derived *>(this)->on_light_change(state);
+    });
+}
+
+template<typename Derived>
+void GreeACVariant<Derived>::set_ionizer_switch(switch_::Switch *ionizer_switch)
+{
+    this->ionizer_switch_ = ionizer_switch;
+    this->ionizer_switch_->add_on_state_callback([this](bool state) {
+        if (state == this->ionizer_state_)
+            return;
+        static_cast<Derived *>(this)->on_ionizer_change(state);
+    });
+}
+
+template<typename Derived>
+void GreeACVariant<Derived>::set_beeper_switch(switch_::Switch *beeper_switch)
+{
+    this->beeper_switch_ = beeper_switch;
+    this->beeper_switch_->add_on_state_callback([this](bool state) {
+        if (state == this->beeper_state_)
+            return;
+        static_cast<Derived *>(this)->on_beeper_change(state);
+    });
+}
+
+template<typename Derived>
+void GreeACVariant<Derived>::set_sleep_switch(switch_::Switch *sleep_switch)
+{
+    this->sleep_switch_ = sleep_switch;
+    this->sleep_switch_->add_on_state_callback([this](bool state) {
+        if (state == this->sleep_state_)
+            return;
+        static_cast<Derived *>(this)->on_sleep_change(state);
+    });
+}
+
+template<typename Derived>
+void GreeACVariant<Derived>::set_xfan_switch(switch_::Switch *xfan_switch)
+{
+    this->xfan_switch_ = xfan_switch;
+    this->xfan_switch_->add_on_state_callback([this](bool state) {
+        if (state == this->xfan_state_)
+            return;
+        static_cast<Derived *>(this)->on_xfan_change(state);
+    });
+}
+
+template<typename Derived>
+void GreeACVariant<Derived>::set_powersave_switch(switch_::Switch *powersave_switch)
+{
+    this->powersave_switch_ = powersave_switch;
+    this->powersave_switch_->add_on_state_callback([this](bool state) {
+        if (state == this->powersave_state_)
+            return;
+        static_cast<Derived *>(this)->on_powersave_change(state);
+    });
+}
+
+template<typename Derived>
+void GreeACVariant<Derived>::set_turbo_switch(switch_::Switch *turbo_switch)
+{
+    this->turbo_switch_ = turbo_switch;
+    this->turbo_switch_->add_on_state_callback([this](bool state) {
+        if (state == this->turbo_state_)
+            return;
+        static_cast<Derived *>(this)->on_turbo_change(state);
+    });
+}
+
+template<typename Derived>
+void GreeACVariant<Derived>::set_ifeel_switch(switch_::Switch *ifeel_switch)
+{
+    this->ifeel_switch_ = ifeel_switch;
+    this->ifeel_switch_->add_on_state_callback([this](bool state) {
+        if (state == this->ifeel_state_)
+            return;
+        static_cast<Derived *>(this)->on_ifeel_change(state);
+    });
+}
+
+template<typename Derived>
+void GreeACVariant<Derived>::set_quiet_select(select::Select *quiet_select)
+{
+    this->quiet_select_ = quiet_select;
+    this->quiet_select_->add_on_state_callback([this](size_t index) {
+        auto value = this->quiet_select_->at(index);
+        if (!value.has_value() || *value == this->quiet_state_)
+            return;
+        static_cast<Derived *>(this)->on_quiet_change(*value);
+    });
+}
+
 }  // namespace gree_ac
 }  // namespace esphome
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "esphome/components/button/button.h"
+#include "esphome/core/helpers.h"
+#include "gree_ac.h"
+
+namespace esphome {
+namespace gree_ac {
+
+/* logs the packet capture ring on press, usable from the API and web_server */
+class GreeACCaptureButton : public button::Button, public Parented<GreeAC> {
+    protected:
+        void press_action() override { this->parent_->dump_capture(); }
+};
+
+/* logs the minute history on press, for backfilling gaps */
+class GreeACHistoryButton : public button::Button, public Parented<GreeAC> {
+    protected:
+        void press_action() override { this->parent_->dump_history(); }
+};
+
+#ifdef USE_GREE_AC_TRACE
+/* logs the command trace as Chrome trace JSON on press */
+class GreeACTraceButton : public button::Button, public Parented<GreeAC> {
+    protected:
+        void press_action() override { this->parent_->dump_trace(); }
+};
+#endif
+
+}  // namespace gree_ac
+}  // namespace esphome
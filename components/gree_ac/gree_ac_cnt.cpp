@@ -1,6 +1,9 @@
 // based on: https://github.com/DomiStyle/esphome-panasonic-ac
 #include "gree_ac_cnt.h"
+#include "esphome/core/helpers.h"
 #include "esphome/core/log.h"
+#include <cinttypes>
+#include <cmath>
 #include <cstring>
 
 namespace esphome {
@@ -9,40 +12,211 @@ namespace CNT {
 
 static const char *const TAG = "gree_ac.serial";
 
-static const uint8_t ALLOWED_PACKETS[] = {protocol::CMD_IN_UNIT_REPORT};
-static const uint8_t BYTES_TO_CHECK[] = {4, 5, 6, 8, 9, 11, 16, 18, 40};
+/* Gree CNT first, then ASC-18 node settings, then the remaining combinations */
+static const LineSettings_t LINE_SETTINGS[] = {
+    {4800, uart::UART_CONFIG_PARITY_EVEN},
+    {9600, uart::UART_CONFIG_PARITY_NONE},
+    {9600, uart::UART_CONFIG_PARITY_EVEN},
+    {4800, uart::UART_CONFIG_PARITY_NONE},
+};
 
-void GreeACCNT::setup()
+template<typename Policy>
+void GreeACCNTEngine<Policy>::setup()
 {
     GreeAC::setup();
-    ESP_LOGD(TAG, "Using serial protocol for Gree AC");
+    ESP_LOGD(TAG, "Using serial protocol %s", Policy::NAME);
     memset(this->lastpacket, 0, sizeof(this->lastpacket));
+
+    if (this->restore_saved_state_enabled_)
+    {
+        restore_saved_state();
+    }
+
+    if (this->sniffer_)
+    {
+        ESP_LOGI(TAG, "Sniffer mode - transmit disabled");
+        this->tx_enabled_ = false;
+        this->sniffer_stats_.last_summary = millis();
+    }
+
+    if (this->auto_detect_)
+    {
+        start_line_detection();
+    }
+}
+
+/*
+ * Line settings auto-detection - the unit reports tell us when we got it right
+ */
+template<typename Policy>
+void GreeACCNTEngine<Policy>::start_line_detection()
+{
+    /* start with whatever is configured, it is most likely right */
+    bool configured = false;
+    this->detect_index_ = 0;
+    for (uint8_t i = 0; i < sizeof(LINE_SETTINGS) / sizeof(LINE_SETTINGS[0]); i++)
+    {
+        if (LINE_SETTINGS[i].baud_rate == this->parent_->get_baud_rate() &&
+            LINE_SETTINGS[i].parity == this->parent_->get_parity())
+        {
+            this->detect_index_ = i;
+            configured = true;
+            break;
+        }
+    }
+
+    this->detecting_ = true;
+    if (!configured)
+    {
+        apply_line_settings(this->detect_index_);
+    }
+    this->type_c_frames_ = 0;
+    this->type_c_len_ = 0;
+    this->detect_started_ = millis();
+    ESP_LOGI(TAG, "Detecting line settings, trying %" PRIu32 " baud, parity %d",
+             LINE_SETTINGS[this->detect_index_].baud_rate, (int)LINE_SETTINGS[this->detect_index_].parity);
+}
+
+template<typename Policy>
+void GreeACCNTEngine<Policy>::apply_line_settings(uint8_t index)
+{
+    this->parent_->set_baud_rate(LINE_SETTINGS[index].baud_rate);
+    this->parent_->set_parity(LINE_SETTINGS[index].parity);
+    this->parent_->set_data_bits(8);
+    this->parent_->set_stop_bits(1);
+    this->parent_->load_settings(false);
+
+    /* whatever was received so far was read with wrong settings */
+    this->serialProcess_.state = STATE_RESTART;
+    this->wait_response_ = false;
+    this->type_c_frames_ = 0;
+    this->type_c_len_ = 0;
+    this->detect_started_ = millis();
+}
+
+template<typename Policy>
+void GreeACCNTEngine<Policy>::detect_line()
+{
+    if (this->type_c_frames_ >= protocol::DETECT_TYPE_C_FRAMES)
+    {
+        /* keep cycling - the frames may come from a different device sharing the line, or noise that passed the CRC */
+        ESP_LOGE(TAG, "Sinclair Type-C frames detected at %" PRIu32 " baud - this unit is not supported by gree_ac",
+                 LINE_SETTINGS[this->detect_index_].baud_rate);
+        Component::status_set_error();
+    }
+    else if (millis() - this->detect_started_ < protocol::TIME_DETECT_DWELL_MS)
+    {
+        return;
+    }
+
+    this->detect_index_ = (this->detect_index_ + 1) % (sizeof(LINE_SETTINGS) / sizeof(LINE_SETTINGS[0]));
+    ESP_LOGD(TAG, "No unit reports, trying %" PRIu32 " baud, parity %d",
+             LINE_SETTINGS[this->detect_index_].baud_rate, (int)LINE_SETTINGS[this->detect_index_].parity);
+    apply_line_settings(this->detect_index_);
+}
+
+template<typename Policy>
+void GreeACCNTEngine<Policy>::dump_config()
+{
+    GreeAC::dump_config();
+    ESP_LOGCONFIG(TAG, "  Protocol: %s", Policy::NAME);
+    ESP_LOGCONFIG(TAG, "  Sniffer: %s", YESNO(this->sniffer_));
+    ESP_LOGCONFIG(TAG, "  Line Auto-Detect: %s", YESNO(this->auto_detect_));
+    ESP_LOGCONFIG(TAG, "  Restore State: %s", YESNO(this->restore_saved_state_enabled_));
+    if (this->restore_saved_state_enabled_)
+    {
+        ESP_LOGCONFIG(TAG, "  State Save Interval: %" PRIu32 " ms", this->state_save_interval_);
+        ESP_LOGCONFIG(TAG, "  Flash Writes: %" PRIu32 " (since boot: %" PRIu32 ")", this->saved_state_.write_count, this->saves_since_boot_);
+    }
+    LOG_SENSOR("  ", "Flash Writes", this->flash_writes_sensor_);
+    LOG_SENSOR("  ", "Link Quality", this->link_quality_sensor_);
+    LOG_SENSOR("  ", "Stock Command Interval", this->stock_command_interval_sensor_);
+    LOG_SENSOR("  ", "Stock Response Latency", this->stock_response_latency_sensor_);
+    if (this->local_control_.algorithm != LocalControl::None)
+    {
+        ESP_LOGCONFIG(TAG, "  Local Control: %s on %s, update %" PRIu32 " ms, command spacing %" PRIu32 " ms",
+                      this->local_control_.algorithm == LocalControl::PI ? "PI" : "hysteresis",
+                      this->local_control_.output == LocalControlOutput::Fan ? "fan" : "setpoint",
+                      this->local_control_.update_interval, this->local_control_.min_command_interval);
+    }
+    if (this->ifeel_forwarding_)
+    {
+        ESP_LOGCONFIG(TAG, "  iFeel Forwarding: interval %" PRIu32 " ms, deadband %.1f", this->ifeel_interval_, this->ifeel_deadband_);
+    }
+    for (const Telemetry_t &telemetry : this->telemetry_)
+    {
+        LOG_SENSOR("  ", "Telemetry", telemetry.sensor);
+        ESP_LOGCONFIG(TAG, "    Frame %02X, Byte %u, Sampling %" PRIu32 " ms, Publish %" PRIu32 " ms",
+                      telemetry.command, telemetry.byte, telemetry.sampling_interval, telemetry.publish_interval);
+    }
 }
 
-void GreeACCNT::loop()
+template<typename Policy>
+void GreeACCNTEngine<Policy>::loop()
 {
+    GREE_AC_PROFILE(PHASE_LOOP);
+
     /* this reads data from UART */
     GreeAC::loop();
 
+    if (this->detecting_)
+    {
+        detect_line();
+    }
+
     /* we have a frame from AC */
     if (this->serialProcess_.state == STATE_COMPLETE)
     {
         /* log for ESPHome debug */
-        log_packet(this->serialProcess_.data);
+        this->log_packet(this->serialProcess_.data);
+
+        /* telemetry frames come on their own schedule, they do not answer our SET frames */
+        bool telemetry = is_telemetry_packet();
 
         /* mark that we have received a response (even if it might be invalid) */
-        this->wait_response_ = false;
+        bool solicited = this->wait_response_ && !telemetry;
+        if (solicited)
+        {
+            this->wait_response_ = false;
+            link_response(true);
+        }
 
-        if (verify_packet())  /* Verify length, header, counter and checksum */
+        if (this->sniffer_ && sniff_packet())
         {
+            /* frame sent by stock module, it is not for us to decode */
+        }
+        else if (telemetry)
+        {
+            handle_telemetry_packet();
+        }
+        else if (verify_packet())  /* Verify length, header, counter and checksum */
+        {
+            link_report();
             this->last_packet_received_ = millis();  /* Set the time at which we received our last packet */
 
+            if (this->detecting_)
+            {
+                ESP_LOGI(TAG, "Unit reports decoded at %" PRIu32 " baud, parity %d - line settings locked",
+                         LINE_SETTINGS[this->detect_index_].baud_rate, (int)LINE_SETTINGS[this->detect_index_].parity);
+                this->detecting_ = false;
+                Component::status_clear_error();
+            }
+            learn_report_cadence(solicited);
+
             /* A valid recieved packet of accepted type marks module as being ready */
             if (this->state_ != ACState::Ready)
             {
                 this->state_ = ACState::Ready;
-                Component::status_clear_error();
                 this->last_packet_sent_ = millis();
+                if (!this->synced_)
+                {
+                    /* first report - answer right away instead of waiting a full refresh period */
+                    this->last_packet_sent_ -= protocol::TIME_REFRESH_PERIOD_MS;
+                }
+
+                /* announce ourselves and the clock right after the unit starts talking */
+                this->tx_schedule_[(uint8_t)TxMessage::SyncTime].last_sent  = millis() - this->tx_schedule_[(uint8_t)TxMessage::SyncTime].period_ms;
+                this->tx_schedule_[(uint8_t)TxMessage::MacReport].last_sent = millis() - this->tx_schedule_[(uint8_t)TxMessage::MacReport].period_ms;
             }
 
             if (this->update_ == ACUpdate::NoUpdate)
@@ -55,29 +229,267 @@ void GreeACCNT::loop()
         this->serialProcess_.state = STATE_RESTART;
     }
 
+    update_local_control();
+
+    /* a new room temperature is a command, keep-alives carry the no-change flag and are ignored by the unit */
+    if (this->ifeel_state_ && this->state_ == ACState::Ready && this->tx_enabled_ && this->update_ == ACUpdate::NoUpdate &&
+        update_ifeel_temperature())
+    {
+        this->update_ = ACUpdate::UpdateStart;
+    }
+
     /* we will send a packet to the AC as a response to indicate changes */
     send_packet();
 
+    flush_state_save();
+
+    if (this->sniffer_)
+    {
+        sniffer_summary();
+    }
+
     /* if there are no packets for some time - mark module as not ready */
-    if (millis() - this->last_packet_received_ >= protocol::TIME_TIMEOUT_INACTIVE_MS)
+    if (millis() - this->last_packet_received_ >= this->link_.inactive_timeout)
     {
         if (this->state_ != ACState::Initializing)
         {
+            ESP_LOGW(TAG, "No reports for %" PRIu32 " ms", this->link_.inactive_timeout);
             this->state_ = ACState::Initializing;
+            this->counters_[COUNTER_STATE_FLAPS]++;
+        }
+    }
+
+    update_link_health();
+}
+
+/*
+ * Sniffer - time frames of both directions to get a baseline from the stock module
+ * returns true if the frame came from the stock module
+ */
+template<typename Policy>
+bool GreeACCNTEngine<Policy>::sniff_packet()
+{
+    const std::vector<uint8_t> &data = this->serialProcess_.data;
+    if (data.size() < 5)
+    {
+        return false;
+    }
+
+    uint8_t command = data[3];
+    bool from_module = command == Policy::CMD_OUT_PARAMS_SET || command == Policy::CMD_OUT_SYNC_TIME ||
+                       command == Policy::CMD_OUT_MAC_REPORT || command == Policy::CMD_OUT_UNKNOWN_1;
+    SnifferStats_t &stats = this->sniffer_stats_;
+
+    ESP_LOGD(TAG, "%s frame 0x%02X, %u bytes, %" PRIu32 "-%" PRIu32 " ms", from_module ? "Module" : "Unit",
+             command, (unsigned)data.size(), this->serialProcess_.first_byte_time, this->serialProcess_.last_byte_time);
+
+    if (command == Policy::CMD_OUT_PARAMS_SET)
+    {
+        if (stats.commands != 0)
+        {
+            uint32_t interval = this->serialProcess_.last_byte_time - stats.last_command_end;
+            stats.interval = stats.commands == 1 ? interval : (stats.interval * (protocol::SNIFFER_EWMA_WEIGHT - 1) + interval) / protocol::SNIFFER_EWMA_WEIGHT;
+            stats.interval_min = (stats.commands == 1 || interval < stats.interval_min) ? interval : stats.interval_min;
+            stats.interval_max = interval > stats.interval_max ? interval : stats.interval_max;
+        }
+        stats.commands++;
+        stats.last_command_end = this->serialProcess_.last_byte_time;
+        stats.awaiting_response = true;
+    }
+    else if (command == Policy::CMD_IN_UNIT_REPORT && stats.awaiting_response)
+    {
+        uint32_t latency = this->serialProcess_.first_byte_time - stats.last_command_end;
+        stats.latency = stats.responses == 0 ? latency : (stats.latency * (protocol::SNIFFER_EWMA_WEIGHT - 1) + latency) / protocol::SNIFFER_EWMA_WEIGHT;
+        stats.latency_min = (stats.responses == 0 || latency < stats.latency_min) ? latency : stats.latency_min;
+        stats.latency_max = latency > stats.latency_max ? latency : stats.latency_max;
+        stats.responses++;
+        stats.awaiting_response = false;
+    }
+
+    return from_module;
+}
+
+template<typename Policy>
+void GreeACCNTEngine<Policy>::sniffer_summary()
+{
+    SnifferStats_t &stats = this->sniffer_stats_;
+    if (millis() - stats.last_summary < protocol::TIME_SNIFFER_SUMMARY_MS)
+    {
+        return;
+    }
+    stats.last_summary = millis();
+
+    ESP_LOGI(TAG, "Stock module: %" PRIu32 " SET, every %" PRIu32 " ms (%" PRIu32 "-%" PRIu32 "), "
+             "%" PRIu32 " answered after %" PRIu32 " ms (%" PRIu32 "-%" PRIu32 ")",
+             stats.commands, stats.interval, stats.interval_min, stats.interval_max,
+             stats.responses, stats.latency, stats.latency_min, stats.latency_max);
+
+    if (this->stock_command_interval_sensor_ != nullptr && stats.commands > 1)
+    {
+        this->stock_command_interval_sensor_->publish_state(stats.interval);
+    }
+    if (this->stock_response_latency_sensor_ != nullptr && stats.responses > 0)
+    {
+        this->stock_response_latency_sensor_->publish_state(stats.latency);
+    }
+}
+
+/*
+ * Link health - EWMAs of frame errors, response rate, latency and report interval
+ */
+template<typename Policy>
+void GreeACCNTEngine<Policy>::link_frame(bool valid)
+{
+    this->link_.error_rate += protocol::LINK_EWMA_ALPHA * ((valid ? 0.0f : 1.0f) - this->link_.error_rate);
+}
+
+template<typename Policy>
+void GreeACCNTEngine<Policy>::link_response(bool received)
+{
+    this->link_.response_rate += protocol::LINK_EWMA_ALPHA * ((received ? 1.0f : 0.0f) - this->link_.response_rate);
+    if (!received)
+    {
+        return;
+    }
+
+    /* same estimator as TCP retransmission timer: mean + 4 * mean deviation */
+    float latency = millis() - this->last_packet_sent_;
+    if (this->link_.latency == 0.0f)
+    {
+        this->link_.latency = latency;
+        this->link_.latency_dev = latency / 2;
+    }
+    else
+    {
+        this->link_.latency_dev += protocol::LINK_EWMA_ALPHA * (fabsf(latency - this->link_.latency) - this->link_.latency_dev);
+        this->link_.latency += protocol::LINK_EWMA_ALPHA * (latency - this->link_.latency);
+    }
+    this->link_.response_timeout = clamp<uint32_t>(this->link_.latency + 4 * this->link_.latency_dev,
+                                                   protocol::TIME_WAIT_RESPONSE_MIN_MS, protocol::TIME_WAIT_RESPONSE_MAX_MS);
+}
+
+template<typename Policy>
+void GreeACCNTEngine<Policy>::link_report()
+{
+    /* interval is meaningful only while reports keep coming */
+    if (this->state_ == ACState::Ready)
+    {
+        float interval = millis() - this->last_packet_received_;
+        if (this->link_.interval == 0.0f)
+        {
+            this->link_.interval = interval;
+            this->link_.interval_dev = interval / 2;
+        }
+        else
+        {
+            this->link_.interval_dev += protocol::LINK_EWMA_ALPHA * (fabsf(interval - this->link_.interval) - this->link_.interval_dev);
+            this->link_.interval += protocol::LINK_EWMA_ALPHA * (interval - this->link_.interval);
+        }
+        /* tolerate a couple of lost reports before calling the unit gone */
+        this->link_.inactive_timeout = clamp<uint32_t>(3 * this->link_.interval + 4 * this->link_.interval_dev,
+                                                       protocol::TIME_TIMEOUT_INACTIVE_MS, protocol::TIME_TIMEOUT_INACTIVE_MAX_MS);
+    }
+}
+
+template<typename Policy>
+float GreeACCNTEngine<Policy>::link_quality()
+{
+    if (this->state_ != ACState::Ready)
+    {
+        return 0.0f;
+    }
+    return 100.0f * (1.0f - this->link_.error_rate) * this->link_.response_rate;
+}
+
+template<typename Policy>
+void GreeACCNTEngine<Policy>::update_link_health()
+{
+    uint32_t now = millis();
+    float quality = link_quality();
+
+    /* single lost or damaged frames are normal, only complain if it lasts */
+    if (quality < protocol::LINK_QUALITY_MIN)
+    {
+        if (this->link_.degraded_since == 0)
+        {
+            this->link_.degraded_since = now | 1;
+        }
+        else if (!this->link_.error && now - this->link_.degraded_since >= protocol::TIME_LINK_DEGRADED_MS)
+        {
+            ESP_LOGW(TAG, "Link degraded (quality %.0f%%, error rate %.2f, response rate %.2f)",
+                     quality, this->link_.error_rate, this->link_.response_rate);
+            this->link_.error = true;
             Component::status_set_error();
         }
     }
+    else
+    {
+        this->link_.degraded_since = 0;
+        if (this->link_.error)
+        {
+            ESP_LOGI(TAG, "Link recovered");
+            this->link_.error = false;
+            Component::status_clear_error();
+        }
+    }
+
+    if (this->link_quality_sensor_ != nullptr && now - this->link_.last_publish >= protocol::TIME_LINK_PUBLISH_MS)
+    {
+        this->link_.last_publish = now;
+        this->link_quality_sensor_->publish_state(quality);
+    }
 }
 
 /*
  * ESPHome control request
  */
 
-void GreeACCNT::control(const climate::ClimateCall &call)
+template<typename Policy>
+void GreeACCNTEngine<Policy>::control(const climate::ClimateCall &call)
 {
-    if (this->state_ != ACState::Ready)
+    if (this->state_ != ACState::Ready || !this->tx_enabled_)
         return;
 
+#ifdef USE_GREE_AC_TRACE
+    /* changes not sent yet go out in the same SET frame */
+    bool merged = this->update_ == ACUpdate::UpdateStart;
+    if (!merged)
+    {
+        this->trace_id_++;
+        this->trace_record(TRACE_CONTROL);
+    }
+    this->trace_record(TRACE_COALESCE, merged);
+#endif
+
+    if (call.get_preset().has_value() || call.has_custom_preset())
+    {
+        apply_preset(call);
+    }
+    else if (!this->presets_.empty() &&
+             (call.get_mode().has_value() || call.get_target_temperature().has_value() ||
+              call.has_custom_fan_mode() || call.get_swing_mode().has_value()))
+    {
+        /* manual change - settings no longer match the preset */
+        this->set_preset_(climate::CLIMATE_PRESET_NONE);
+    }
+
+    /* a fan mode picked by the user wins over the fan output of local control */
+    if (call.has_custom_fan_mode())
+    {
+        this->control_fan_owned_ = false;
+        this->control_fan_suspended_ = true;
+    }
+    else if (call.get_mode().has_value() || call.get_target_temperature().has_value())
+    {
+        this->control_fan_suspended_ = false;
+    }
+
+    /* new target or mode - the unit gets them as they are until local control steps again */
+    if (call.get_mode().has_value() || call.get_target_temperature().has_value())
+    {
+        release_local_control();
+    }
+
     if (call.get_mode().has_value())
     {
         ESP_LOGV(TAG, "Requested mode change");
@@ -91,13 +503,13 @@ void GreeACCNT::control(const climate::ClimateCall &call)
         ESP_LOGV(TAG, "Requested target teperature change");
         this->update_ = ACUpdate::UpdateStart;
         this->target_temperature = *call.get_target_temperature();
-        if (this->target_temperature < MIN_TEMPERATURE)
+        if (this->target_temperature < GreeAC::MIN_TEMPERATURE)
         {
-            this->target_temperature = MIN_TEMPERATURE;
+            this->target_temperature = GreeAC::MIN_TEMPERATURE;
         }
-        else if (this->target_temperature > MAX_TEMPERATURE)
+        else if (this->target_temperature > GreeAC::MAX_TEMPERATURE)
         {
-            this->target_temperature = MAX_TEMPERATURE;
+            this->target_temperature = GreeAC::MAX_TEMPERATURE;
         }
     }
 
@@ -146,17 +558,352 @@ void GreeACCNT::control(const climate::ClimateCall &call)
                 this->horizontal_swing_state_ = horizontal_swing_options::CMID;
                 break;
         }
+        this->swing_mode = *call.get_swing_mode();
+    }
+
+    /* show requested state right away, handle_packet() keeps it until the unit confirms or the time is up */
+    if (this->optimistic_ && this->update_ != ACUpdate::NoUpdate)
+    {
+        this->optimistic_request_.pending = true;
+        this->optimistic_request_.since = millis();
+        this->optimistic_request_.mode = this->mode;
+        this->optimistic_request_.target_temperature = this->target_temperature;
+        this->optimistic_request_.fan_mode = this->has_custom_fan_mode() ? this->get_custom_fan_mode() : nullptr;
+        this->optimistic_request_.swing_mode = this->swing_mode;
+        this->publish_state();
+#ifdef USE_GREE_AC_TRACE
+        this->trace_record(TRACE_PUBLISH, 1);
+#endif
+    }
+
+#ifdef USE_GREE_AC_TRACE
+    if (this->update_ == ACUpdate::UpdateStart)
+    {
+        this->trace_record(TRACE_QUEUED);
+    }
+    else if (!merged)
+    {
+        this->trace_record(TRACE_DONE, 0);
+    }
+#endif
+}
+
+/*
+ * Last known state in flash - restored as provisional state until the unit reports
+ */
+template<typename Policy>
+void GreeACCNTEngine<Policy>::restore_saved_state()
+{
+    this->state_pref_ = global_preferences->template make_preference<SavedState_t<Policy>>(this->get_object_id_hash() ^ fnv1_hash("gree_ac_state"), true);
+
+    if (!this->state_pref_.load(&this->saved_state_) || this->saved_state_.version != protocol::SAVED_STATE_VERSION)
+    {
+        ESP_LOGD(TAG, "No saved state to restore");
+        memset(&this->saved_state_, 0, sizeof(this->saved_state_));
+        this->saved_state_.version = protocol::SAVED_STATE_VERSION;
+        this->saved_state_.target_temperature = NAN;
+        return;
+    }
+
+    /* decode saved report the same way as a received one */
+    this->serialProcess_.data.assign(this->saved_state_.report, this->saved_state_.report + sizeof(this->saved_state_.report));
+    this->processUnitReport();
+    this->serialProcess_.data.clear();
+
+    /* the unit kept running on the setpoint of local control, the room target is ours */
+    if (!std::isnan(this->saved_state_.target_temperature) && this->local_control_.algorithm != LocalControl::None &&
+        this->local_control_.output == LocalControlOutput::Setpoint)
+    {
+        this->target_temperature = this->saved_state_.target_temperature;
+        this->control_adopt_setpoint_ = true;
+    }
+
+    /* room temperature is long outdated */
+    if (this->current_temperature_sensor_ == nullptr)
+    {
+        this->current_temperature = NAN;
+    }
+
+    ESP_LOGI(TAG, "Restored last known state (provisional until first report)");
+    this->publish_state();
+
+    if (this->flash_writes_sensor_ != nullptr)
+    {
+        this->flash_writes_sensor_->publish_state(this->saved_state_.write_count);
+    }
+}
+
+template<typename Policy>
+void GreeACCNTEngine<Policy>::queue_state_save()
+{
+    if (!this->restore_saved_state_enabled_ || this->serialProcess_.data.size() < Policy::SET_PACKET_LEN)
+    {
+        return;
+    }
+
+    /* only settings count, room temperature changes would wear the flash out - and so would local control steps,
+       while it owns the unit setpoint the room target is kept instead */
+    bool local = !std::isnan(this->unit_setpoint_);
+    float target = local ? this->target_temperature : NAN;
+    bool changed = std::isnan(target) != std::isnan(this->saved_state_.target_temperature) ||
+                   (local && target != this->saved_state_.target_temperature);
+    for (uint8_t i : Policy::REPORT_CHANGE_BYTES)
+    {
+        if (local && i == Policy::REPORT_TEMP_SET_BYTE)
+        {
+            continue;
+        }
+        if (this->saved_state_.report[i] != this->serialProcess_.data[i])
+        {
+            changed = true;
+            break;
+        }
+    }
+    if (!changed)
+    {
+        return;
+    }
+
+    memcpy(this->saved_state_.report, this->serialProcess_.data.data(), sizeof(this->saved_state_.report));
+    this->saved_state_.target_temperature = target;
+    if (!this->save_pending_)
+    {
+        this->save_pending_ = true;
+        this->save_requested_ = millis();
+    }
+}
+
+template<typename Policy>
+void GreeACCNTEngine<Policy>::flush_state_save()
+{
+    if (!this->save_pending_)
+    {
+        return;
+    }
+
+    uint32_t now = millis();
+    if (now - this->save_requested_ < protocol::TIME_SAVE_COALESCE_MS)
+    {
+        return;
+    }
+    if (this->saves_since_boot_ != 0 && now - this->last_save_ < this->state_save_interval_)
+    {
+        return;
+    }
+
+    this->saved_state_.write_count++;
+    this->saves_since_boot_++;
+    this->state_pref_.save(&this->saved_state_);
+    this->save_pending_ = false;
+    this->last_save_ = now;
+    ESP_LOGD(TAG, "Saved state to flash (write %" PRIu32 ")", this->saved_state_.write_count);
+
+    if (this->flash_writes_sensor_ != nullptr)
+    {
+        this->flash_writes_sensor_->publish_state(this->saved_state_.write_count);
     }
 }
 
 /*
- * Send a raw packet, as is
+ * Apply all settings of a preset to internal state, so they go to the unit in a single update
  */
-void GreeACCNT::send_packet()
+template<typename Policy>
+void GreeACCNTEngine<Policy>::apply_preset(const climate::ClimateCall &call)
 {
+    if (call.get_preset().has_value() && *call.get_preset() == climate::CLIMATE_PRESET_NONE)
+    {
+        ESP_LOGD(TAG, "Clearing preset");
+        this->set_preset_(climate::CLIMATE_PRESET_NONE);
+        reqmodechange = true;
+        return;
+    }
+
+    const GreeACPreset *preset = this->find_preset(call);
+    if (preset == nullptr)
+    {
+        ESP_LOGW(TAG, "Requested preset is not configured");
+        return;
+    }
+
+    ESP_LOGD(TAG, "Applying preset");
+
+    /* internal state is updated before entities are published, so their callbacks see no change
+       and do not start an update cycle of their own */
+    if (preset->mode.has_value())
+        this->mode = *preset->mode;
+
+    if (preset->target_temperature.has_value())
+        this->target_temperature = clamp<float>(*preset->target_temperature, GreeAC::MIN_TEMPERATURE, GreeAC::MAX_TEMPERATURE);
+
+    if (preset->fan_mode != nullptr)
+        this->set_custom_fan_mode_(preset->fan_mode);
+
+    if (preset->vertical_swing.has_value())
+        this->update_swing_vertical(*preset->vertical_swing);
+    if (preset->horizontal_swing.has_value())
+        this->update_swing_horizontal(*preset->horizontal_swing);
+    this->swing_mode = determine_swing_mode(this->vertical_swing_state_.c_str(), this->horizontal_swing_state_.c_str());
+
+    if (preset->light.has_value())
+        this->update_light(*preset->light);
+    if (preset->ionizer.has_value())
+        this->update_ionizer(*preset->ionizer);
+    if (preset->sleep.has_value())
+        this->update_sleep(*preset->sleep);
+    if (preset->xfan.has_value())
+        this->update_xfan(*preset->xfan);
+    if (preset->powersave.has_value())
+        this->update_powersave(*preset->powersave);
+
+    /* Requirement 1: turbo and quiet exclude each other */
+    if (preset->turbo.has_value())
+    {
+        this->update_turbo(*preset->turbo);
+        if (*preset->turbo)
+            this->update_quiet(quiet_options::OFF);
+    }
+    if (preset->quiet.has_value())
+    {
+        this->update_quiet(*preset->quiet);
+        if (*preset->quiet != quiet_options::OFF)
+            this->update_turbo(false);
+    }
+
+    if (preset->custom_preset.empty())
+        this->set_preset_(preset->preset);
+    else
+        this->set_custom_preset_(preset->custom_preset.c_str());
+
+    reqmodechange = true;
+    this->update_ = ACUpdate::UpdateStart;
+}
+
+/*
+ * TX scheduler - picks the highest priority message that is due
+ */
+template<typename Policy>
+bool GreeACCNTEngine<Policy>::tx_due(TxMessage message)
+{
+    const TxSchedule_t &schedule = this->tx_schedule_[(uint8_t)message];
+
+    switch (message)
+    {
+        case TxMessage::Command:
+            return this->update_ != ACUpdate::NoUpdate &&
+                   millis() - this->last_packet_sent_ >= schedule.period_ms;
+        case TxMessage::KeepAlive:
+            return millis() - this->last_packet_sent_ >= schedule.period_ms;
+        case TxMessage::SyncTime:
+#ifdef USE_TIME
+            if (this->time_ == nullptr || !this->time_->now().is_valid())
+                return false;
+#else
+            return false;
+#endif
+            /* fall through */
+        case TxMessage::MacReport:
+            /* low priority frames only go out in the gap between SET frames, never while a command is pending */
+            return schedule.period_ms != 0 &&
+                   this->state_ == ACState::Ready &&
+                   this->update_ == ACUpdate::NoUpdate &&
+                   millis() - schedule.last_sent >= schedule.period_ms;
+        default:
+            return false;
+    }
+}
+
+template<typename Policy>
+TxMessage GreeACCNTEngine<Policy>::next_tx_message()
+{
+    for (uint8_t i = 0; i < (uint8_t)TxMessage::Count; i++)
+    {
+        if (this->tx_due((TxMessage)i))
+            return (TxMessage)i;
+    }
+    return TxMessage::None;
+}
+
+/*
+ * Bus slot handling - the unit may send reports on its own, learn their cadence
+ * so that our frame fits into the idle gap after a report
+ */
+template<typename Policy>
+void GreeACCNTEngine<Policy>::learn_report_cadence(bool solicited)
+{
+    this->report_air_time_ = this->frame_air_time(this->serialProcess_.data.size());
+
+    /* reports in response to our SET follow our own timing, they tell nothing about the unit */
+    if (solicited)
+    {
+        return;
+    }
+
+    uint32_t report_end = this->serialProcess_.last_byte_time;
+    if (this->last_unsolicited_report_ != 0)
+    {
+        uint32_t interval = report_end - this->last_unsolicited_report_;
+        if (this->report_interval_ == 0)
+        {
+            this->report_interval_ = interval;
+        }
+        else
+        {
+            this->report_interval_ = (this->report_interval_ * (protocol::REPORT_CADENCE_WEIGHT - 1) + interval) / protocol::REPORT_CADENCE_WEIGHT;
+        }
+        ESP_LOGV(TAG, "Unsolicited report interval %" PRIu32 " ms (learned %" PRIu32 " ms)", interval, this->report_interval_);
+    }
+    this->last_unsolicited_report_ = report_end;
+}
+
+template<typename Policy>
+bool GreeACCNTEngine<Policy>::tx_slot_free(uint8_t len)
+{
+    /* never start while a frame from the unit is on the wire */
+    if (this->serialProcess_.state == STATE_RECIEVE ||
+        (this->serialProcess_.state == STATE_WAIT_SYNC && !this->serialProcess_.data.empty()))
+    {
+        return false;
+    }
+
+    uint32_t now = millis();
+    if (now - this->serialProcess_.last_byte_time < protocol::TIME_TX_GUARD_MS)
+    {
+        return false;
+    }
+
+    /* unit went quiet on its own - forget the learned cadence */
+    if (this->report_interval_ != 0 && now - this->last_unsolicited_report_ > 4 * this->report_interval_)
+    {
+        this->report_interval_ = 0;
+        this->last_unsolicited_report_ = 0;
+    }
+
+    /* our frame has to end before the next unsolicited report is expected to start */
+    if (this->report_interval_ > this->report_air_time_)
+    {
+        uint32_t phase = (now - this->last_unsolicited_report_) % this->report_interval_;
+        uint32_t until_report = this->report_interval_ - this->report_air_time_ - phase;
+        if (phase < this->report_interval_ - this->report_air_time_ &&
+            until_report < this->frame_air_time(len) + protocol::TIME_TX_GUARD_MS)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*
+ * Send the next packet to the AC unit, if any is due
+ */
+template<typename Policy>
+void GreeACCNTEngine<Policy>::send_packet()
+{
+    GREE_AC_PROFILE(PHASE_SEND);
+
     if (this->wait_response_)
     {
-        if (millis() - this->last_packet_sent_ < protocol::TIME_WAIT_RESPONSE_TIMEOUT_MS)
+        if (millis() - this->last_packet_sent_ < this->link_.response_timeout)
         {
             /* waiting for report to come */
             return;
@@ -164,21 +911,145 @@ void GreeACCNT::send_packet()
         else
         {
             ESP_LOGW(TAG, "Timed out waiting for response from AC unit");
+            this->counters_[COUNTER_RESPONSE_TIMEOUTS]++;
             this->wait_response_ = false;
+            link_response(false);
         }
     }
 
-    if (millis() - this->last_packet_sent_ < protocol::TIME_REFRESH_PERIOD_MS)
+    if (!this->tx_enabled_)
+    {
+        return;
+    }
+
+    /* read before write - nothing we would send is valid before the first report, unless the unit waits for us */
+    if (this->detecting_)
+    {
+        /* never poll into Type-C traffic */
+        if (millis() - this->detect_started_ < protocol::TIME_DETECT_LISTEN_MS || this->type_c_frames_ > 0)
+            return;
+    }
+    else if (!this->synced_ && millis() - this->init_time_ < protocol::TIME_STARTUP_LISTEN_MS)
+    {
+        return;
+    }
+
+    /* a low priority frame is still on the wire - this delays any command by at most one frame time */
+    if (millis() - this->last_aux_sent_ < this->aux_frame_time_)
+    {
+        return;
+    }
+
+    TxMessage message = this->next_tx_message();
+    if (message == TxMessage::None)
+    {
+        return;
+    }
+
+    /* wait for the idle gap after the unit's report instead of talking over it */
+    uint8_t len = (message == TxMessage::SyncTime)  ? Policy::SYNC_TIME_PACKET_LEN :
+                  (message == TxMessage::MacReport) ? Policy::MAC_REPORT_PACKET_LEN :
+                                                      Policy::SET_PACKET_LEN;
+    if (!this->tx_slot_free(len + 5))
     {
-        /* do net send packet too often */
         return;
     }
 
-    uint8_t payload[protocol::SET_PACKET_LEN];
+    switch (message)
+    {
+        case TxMessage::Command:
+        case TxMessage::KeepAlive:
+            this->send_params_packet();
+            break;
+        case TxMessage::SyncTime:
+            this->send_sync_time_packet();
+            this->tx_schedule_[(uint8_t)message].last_sent = millis();
+            break;
+        case TxMessage::MacReport:
+            this->send_mac_report_packet();
+            this->tx_schedule_[(uint8_t)message].last_sent = millis();
+            break;
+        default:
+            return;
+    }
+}
+
+#ifdef USE_TIME
+template<typename Policy>
+void GreeACCNTEngine<Policy>::send_sync_time_packet()
+{
+    ESPTime now = this->time_->now();
+
+    uint8_t payload[Policy::SYNC_TIME_PACKET_LEN];
+    payload[Policy::SYNC_TIME_YEAR_BYTE]   = (uint8_t)(now.year - 2000);
+    payload[Policy::SYNC_TIME_MONTH_BYTE]  = now.month;
+    payload[Policy::SYNC_TIME_DAY_BYTE]    = now.day_of_month;
+    payload[Policy::SYNC_TIME_HOUR_BYTE]   = now.hour;
+    payload[Policy::SYNC_TIME_MINUTE_BYTE] = now.minute;
+    payload[Policy::SYNC_TIME_SECOND_BYTE] = now.second;
+    payload[Policy::SYNC_TIME_WDAY_BYTE]   = now.day_of_week;
+
+    ESP_LOGV(TAG, "Sending time sync %04u-%02u-%02u %02u:%02u:%02u", now.year, now.month, now.day_of_month,
+             now.hour, now.minute, now.second);
+    write_frame(Policy::CMD_OUT_SYNC_TIME, payload, sizeof(payload));
+
+    /* no report comes as a response, just keep the bus free until the frame is out */
+    this->last_aux_sent_ = millis();
+    this->aux_frame_time_ = this->frame_air_time(sizeof(payload) + 5);
+}
+#else
+template<typename Policy>
+void GreeACCNTEngine<Policy>::send_sync_time_packet() {}
+#endif
+
+template<typename Policy>
+void GreeACCNTEngine<Policy>::send_mac_report_packet()
+{
+    uint8_t payload[Policy::MAC_REPORT_PACKET_LEN];
+    memset(payload, 0, sizeof(payload));
+
+    payload[Policy::MAC_REPORT_CONST_BYTE] = Policy::MAC_REPORT_CONST_VAL;
+    get_mac_address_raw(&payload[Policy::MAC_REPORT_MAC_BYTE]);
+
+    ESP_LOGV(TAG, "Sending MAC report");
+    write_frame(Policy::CMD_OUT_MAC_REPORT, payload, sizeof(payload));
+
+    this->last_aux_sent_ = millis();
+    this->aux_frame_time_ = this->frame_air_time(sizeof(payload) + 5);
+}
+
+/*
+ * Wrap payload in sync, length, command and checksum and send it
+ */
+template<typename Policy>
+void GreeACCNTEngine<Policy>::write_frame(uint8_t command, const uint8_t *payload, uint8_t len)
+{
+    uint8_t full_packet[GreeAC::DATA_MAX];
+    full_packet[0] = Policy::SYNC;
+    full_packet[1] = Policy::SYNC;
+    full_packet[2] = len + 2;
+    full_packet[3] = command;
+    memcpy(&full_packet[4], payload, len);
+
+    full_packet[len + 4] = Policy::checksum(full_packet, len + 5);
+
+    this->write_array(full_packet, len + 5);                 /* Sent the packet by UART */
+    this->tx_bytes_ += len + 5;
+    this->counters_[COUNTER_FRAMES_SENT]++;
+    this->log_packet(full_packet, len + 5, true);            /* Log uart for debug purposes */
+}
+
+/*
+ * Send SET packet - carries either user changes or no-change flag (keep-alive)
+ */
+template<typename Policy>
+void GreeACCNTEngine<Policy>::send_params_packet()
+{
+    uint8_t payload[Policy::SET_PACKET_LEN];
     memset(payload, 0, sizeof(payload));
     
-    payload[protocol::SET_CONST_02_BYTE] = protocol::SET_CONST_02_VAL; /* Some always 0x02 byte... */
-    payload[protocol::SET_CONST_BIT_BYTE] = protocol::SET_CONST_BIT_MASK; /* Some always true bit */
+    payload[Policy::SET_CONST_02_BYTE] = Policy::SET_CONST_02_VAL; /* Some always 0x02 byte... */
+    payload[Policy::SET_CONST_BIT_BYTE] = Policy::SET_CONST_BIT_MASK; /* Some always true bit */
 
     /* Prepare the rest of the frame */
     /* this handles tricky part of 0xAF value and flag marking that WiFi does not apply any changes */
@@ -186,38 +1057,38 @@ void GreeACCNT::send_packet()
     {
         default:
         case ACUpdate::NoUpdate:
-            payload[protocol::SET_NOCHANGE_BYTE] |= protocol::SET_NOCHANGE_MASK;
+            payload[Policy::SET_NOCHANGE_BYTE] |= Policy::SET_NOCHANGE_MASK;
             break;
         case ACUpdate::UpdateStart:
-            payload[protocol::SET_AF_BYTE] = protocol::SET_AF_VAL;
+            payload[Policy::SET_AF_BYTE] = Policy::SET_AF_VAL;
             break;
         case ACUpdate::UpdateClear:
             break;
     }
 
     /* MODE and POWER --------------------------------------------------------------------------- */
-    uint8_t mode = protocol::REPORT_MODE_AUTO;
+    uint8_t mode = Policy::REPORT_MODE_AUTO;
     bool power = false;
     switch (this->mode)
     {
         case climate::CLIMATE_MODE_AUTO:
-            mode = protocol::REPORT_MODE_AUTO;
+            mode = Policy::REPORT_MODE_AUTO;
             power = true;
             break;
         case climate::CLIMATE_MODE_COOL:
-            mode = protocol::REPORT_MODE_COOL;
+            mode = Policy::REPORT_MODE_COOL;
             power = true;
             break;
         case climate::CLIMATE_MODE_DRY:
-            mode = protocol::REPORT_MODE_DRY;
+            mode = Policy::REPORT_MODE_DRY;
             power = true;
             break;
         case climate::CLIMATE_MODE_FAN_ONLY:
-            mode = protocol::REPORT_MODE_FAN;
+            mode = Policy::REPORT_MODE_FAN;
             power = true;
             break;
         case climate::CLIMATE_MODE_HEAT:
-            mode = protocol::REPORT_MODE_HEAT;
+            mode = Policy::REPORT_MODE_HEAT;
             power = true;
             break;
         default:
@@ -226,34 +1097,34 @@ void GreeACCNT::send_packet()
             switch (this->mode_internal_)
             {
                 case climate::CLIMATE_MODE_AUTO:
-                    mode = protocol::REPORT_MODE_AUTO;
+                    mode = Policy::REPORT_MODE_AUTO;
                     break;
                 case climate::CLIMATE_MODE_COOL:
-                    mode = protocol::REPORT_MODE_COOL;
+                    mode = Policy::REPORT_MODE_COOL;
                     break;
                 case climate::CLIMATE_MODE_DRY:
-                    mode = protocol::REPORT_MODE_DRY;
+                    mode = Policy::REPORT_MODE_DRY;
                     break;
                 case climate::CLIMATE_MODE_FAN_ONLY:
-                    mode = protocol::REPORT_MODE_FAN;
+                    mode = Policy::REPORT_MODE_FAN;
                     break;
                 case climate::CLIMATE_MODE_HEAT:
-                    mode = protocol::REPORT_MODE_HEAT;
+                    mode = Policy::REPORT_MODE_HEAT;
                     break;
             }
             power = false;
             break;
     }
 
-    payload[protocol::REPORT_MODE_BYTE] |= (mode << protocol::REPORT_MODE_POS);
+    payload[Policy::REPORT_MODE_BYTE] |= (mode << Policy::REPORT_MODE_POS);
     if (power)
     {
-        payload[protocol::REPORT_PWR_BYTE] |= protocol::REPORT_PWR_MASK;
+        payload[Policy::REPORT_PWR_BYTE] |= Policy::REPORT_PWR_MASK;
     }
 
     /* TARGET TEMPERATURE --------------------------------------------------------------------------- */
-    uint8_t target_temperature = static_cast<uint8_t>(round(this->target_temperature));
-    payload[protocol::REPORT_TEMP_SET_BYTE] |= ((target_temperature - protocol::REPORT_TEMP_SET_OFF) << protocol::REPORT_TEMP_SET_POS) & protocol::REPORT_TEMP_SET_MASK;
+    uint8_t target_temperature = static_cast<uint8_t>(round(unit_target_temperature()));
+    payload[Policy::REPORT_TEMP_SET_BYTE] |= ((target_temperature - Policy::REPORT_TEMP_SET_OFF) << Policy::REPORT_TEMP_SET_POS) & Policy::REPORT_TEMP_SET_MASK;
 
     /* FAN SPEED --------------------------------------------------------------------------- */
     /* below will default to AUTO */
@@ -293,206 +1164,204 @@ void GreeACCNT::send_packet()
             fan_mode_byte18 = 0x0D;
         }
 
-        payload[protocol::REPORT_FAN_SPD2_BYTE] |= (fan_mode_byte4 << protocol::REPORT_FAN_SPD2_POS);
-        payload[protocol::REPORT_FAN_SPD1_BYTE] |= (fan_mode_byte18 << protocol::REPORT_FAN_SPD1_POS);
+        payload[Policy::REPORT_FAN_SPD2_BYTE] |= (fan_mode_byte4 << Policy::REPORT_FAN_SPD2_POS);
+        payload[Policy::REPORT_FAN_SPD1_BYTE] |= (fan_mode_byte18 << Policy::REPORT_FAN_SPD1_POS);
     }
 
     if (this->turbo_state_)
     {
-        payload[protocol::REPORT_FAN_TURBO_BYTE] |= protocol::REPORT_FAN_TURBO_MASK;
+        payload[Policy::REPORT_FAN_TURBO_BYTE] |= Policy::REPORT_FAN_TURBO_MASK;
     }
 
     if (this->quiet_state_ == quiet_options::ON)
     {
-        payload[protocol::REPORT_FAN_QUIET_BYTE] |= protocol::REPORT_FAN_QUIET_MASK;
+        payload[Policy::REPORT_FAN_QUIET_BYTE] |= Policy::REPORT_FAN_QUIET_MASK;
     }
     else if (this->quiet_state_ == quiet_options::AUTO)
     {
-        payload[protocol::REPORT_FAN_QUIET_BYTE] |= protocol::REPORT_FAN_QUIET_AUTO_MASK;
+        payload[Policy::REPORT_FAN_QUIET_BYTE] |= Policy::REPORT_FAN_QUIET_AUTO_MASK;
     }
 
     /* VERTICAL SWING --------------------------------------------------------------------------- */
-    uint8_t mode_vertical_swing = protocol::REPORT_VSWING_OFF;
+    uint8_t mode_vertical_swing = Policy::REPORT_VSWING_OFF;
     if (this->vertical_swing_state_ == vertical_swing_options::OFF)
     {
-        mode_vertical_swing = protocol::REPORT_VSWING_OFF;
+        mode_vertical_swing = Policy::REPORT_VSWING_OFF;
     }
     else if (this->vertical_swing_state_ == vertical_swing_options::FULL)
     {
-        mode_vertical_swing = protocol::REPORT_VSWING_FULL;
+        mode_vertical_swing = Policy::REPORT_VSWING_FULL;
     }
     else if (this->vertical_swing_state_ == vertical_swing_options::DOWN)
     {
-        mode_vertical_swing = protocol::REPORT_VSWING_DOWN;
+        mode_vertical_swing = Policy::REPORT_VSWING_DOWN;
     }
     else if (this->vertical_swing_state_ == vertical_swing_options::MIDD)
     {
-        mode_vertical_swing = protocol::REPORT_VSWING_MIDD;
+        mode_vertical_swing = Policy::REPORT_VSWING_MIDD;
     }
     else if (this->vertical_swing_state_ == vertical_swing_options::MID)
     {
-        mode_vertical_swing = protocol::REPORT_VSWING_MID;
+        mode_vertical_swing = Policy::REPORT_VSWING_MID;
     }
     else if (this->vertical_swing_state_ == vertical_swing_options::MIDU)
     {
-        mode_vertical_swing = protocol::REPORT_VSWING_MIDU;
+        mode_vertical_swing = Policy::REPORT_VSWING_MIDU;
     }
     else if (this->vertical_swing_state_ == vertical_swing_options::UP)
     {
-        mode_vertical_swing = protocol::REPORT_VSWING_UP;
+        mode_vertical_swing = Policy::REPORT_VSWING_UP;
     }
     else if (this->vertical_swing_state_ == vertical_swing_options::CDOWN)
     {
-        mode_vertical_swing = protocol::REPORT_VSWING_CDOWN;
+        mode_vertical_swing = Policy::REPORT_VSWING_CDOWN;
     }
     else if (this->vertical_swing_state_ == vertical_swing_options::CMIDD)
     {
-        mode_vertical_swing = protocol::REPORT_VSWING_CMIDD;
+        mode_vertical_swing = Policy::REPORT_VSWING_CMIDD;
     }
     else if (this->vertical_swing_state_ == vertical_swing_options::CMID)
     {
-        mode_vertical_swing = protocol::REPORT_VSWING_CMID;
+        mode_vertical_swing = Policy::REPORT_VSWING_CMID;
     }
     else if (this->vertical_swing_state_ == vertical_swing_options::CMIDU)
     {
-        mode_vertical_swing = protocol::REPORT_VSWING_CMIDU;
+        mode_vertical_swing = Policy::REPORT_VSWING_CMIDU;
     }
     else if (this->vertical_swing_state_ == vertical_swing_options::CUP)
     {
-        mode_vertical_swing = protocol::REPORT_VSWING_CUP;
+        mode_vertical_swing = Policy::REPORT_VSWING_CUP;
     }
     else
     {
-        mode_vertical_swing = protocol::REPORT_VSWING_OFF;
+        mode_vertical_swing = Policy::REPORT_VSWING_OFF;
     }
-    payload[protocol::REPORT_VSWING_BYTE] |= (mode_vertical_swing << protocol::REPORT_VSWING_POS);
+    payload[Policy::REPORT_VSWING_BYTE] |= (mode_vertical_swing << Policy::REPORT_VSWING_POS);
 
     /* HORIZONTAL SWING --------------------------------------------------------------------------- */
-    uint8_t mode_horizontal_swing = protocol::REPORT_HSWING_OFF;
+    uint8_t mode_horizontal_swing = Policy::REPORT_HSWING_OFF;
     if (this->horizontal_swing_state_ == horizontal_swing_options::OFF)
     {
-        mode_horizontal_swing = protocol::REPORT_HSWING_OFF;
+        mode_horizontal_swing = Policy::REPORT_HSWING_OFF;
     }
     else if (this->horizontal_swing_state_ == horizontal_swing_options::FULL)
     {
-        mode_horizontal_swing = protocol::REPORT_HSWING_FULL;
+        mode_horizontal_swing = Policy::REPORT_HSWING_FULL;
     }
     else if (this->horizontal_swing_state_ == horizontal_swing_options::CLEFT)
     {
-        mode_horizontal_swing = protocol::REPORT_HSWING_CLEFT;
+        mode_horizontal_swing = Policy::REPORT_HSWING_CLEFT;
     }
     else if (this->horizontal_swing_state_ == horizontal_swing_options::CMIDL)
     {
-        mode_horizontal_swing = protocol::REPORT_HSWING_CMIDL;
+        mode_horizontal_swing = Policy::REPORT_HSWING_CMIDL;
     }
     else if (this->horizontal_swing_state_ == horizontal_swing_options::CMID)
     {
-        mode_horizontal_swing = protocol::REPORT_HSWING_CMID;
+        mode_horizontal_swing = Policy::REPORT_HSWING_CMID;
     }
     else if (this->horizontal_swing_state_ == horizontal_swing_options::CMIDR)
     {
-        mode_horizontal_swing = protocol::REPORT_HSWING_CMIDR;
+        mode_horizontal_swing = Policy::REPORT_HSWING_CMIDR;
     }
     else if (this->horizontal_swing_state_ == horizontal_swing_options::CRIGHT)
     {
-        mode_horizontal_swing = protocol::REPORT_HSWING_CRIGHT;
+        mode_horizontal_swing = Policy::REPORT_HSWING_CRIGHT;
     }
     else
     {
-        mode_horizontal_swing = protocol::REPORT_HSWING_OFF;
+        mode_horizontal_swing = Policy::REPORT_HSWING_OFF;
     }
-    payload[protocol::REPORT_HSWING_BYTE] |= (mode_horizontal_swing << protocol::REPORT_HSWING_POS);
+    payload[Policy::REPORT_HSWING_BYTE] |= (mode_horizontal_swing << Policy::REPORT_HSWING_POS);
 
     /* DISPLAY --------------------------------------------------------------------------- */
-    uint8_t display_mode = protocol::REPORT_DISP_MODE_SET;
+    uint8_t display_mode = Policy::REPORT_DISP_MODE_SET;
     if (this->display_state_ == display_options::SET)
     {
-        display_mode = protocol::REPORT_DISP_MODE_SET;
+        display_mode = Policy::REPORT_DISP_MODE_SET;
     }
     else if (this->display_state_ == display_options::ACT)
     {
-        display_mode = protocol::REPORT_DISP_MODE_ACT;
+        display_mode = Policy::REPORT_DISP_MODE_ACT;
     }
 
-    payload[protocol::REPORT_DISP_MODE_BYTE] |= (display_mode << protocol::REPORT_DISP_MODE_POS);
+    payload[Policy::REPORT_DISP_MODE_BYTE] |= (display_mode << Policy::REPORT_DISP_MODE_POS);
 
     if (this->light_state_)
     {
-        payload[protocol::REPORT_DISP_ON_BYTE] |= protocol::REPORT_DISP_ON_MASK;
+        payload[Policy::REPORT_DISP_ON_BYTE] |= Policy::REPORT_DISP_ON_MASK;
     }
 
     /* DISPLAY UNIT --------------------------------------------------------------------------- */
     if (this->display_unit_state_ == display_unit_options::DEGF)
     {
-        payload[protocol::REPORT_DISP_F_BYTE] |= protocol::REPORT_DISP_F_MASK;
+        payload[Policy::REPORT_DISP_F_BYTE] |= Policy::REPORT_DISP_F_MASK;
     }
 
     /* IONIZER -------------------------------------------------------------------------- */
     if (this->ionizer_state_)
     {
-        payload[protocol::REPORT_IONIZER1_BYTE] |= protocol::REPORT_IONIZER1_MASK;
-        payload[protocol::REPORT_IONIZER2_BYTE] |= protocol::REPORT_IONIZER2_MASK;
+        payload[Policy::REPORT_IONIZER1_BYTE] |= Policy::REPORT_IONIZER1_MASK;
+        payload[Policy::REPORT_IONIZER2_BYTE] |= Policy::REPORT_IONIZER2_MASK;
     }
 
     /* BEEPER --------------------------------------------------------------------------- */
     if (!this->beeper_state_)
     {
-        payload[protocol::REPORT_BEEPER_BYTE] |= protocol::REPORT_BEEPER_MASK;
+        payload[Policy::REPORT_BEEPER_BYTE] |= Policy::REPORT_BEEPER_MASK;
     }
 
     /* SLEEP --------------------------------------------------------------------------- */
     if (this->sleep_state_)
     {
-        payload[protocol::REPORT_SLEEP_BYTE] |= protocol::REPORT_SLEEP_MASK;
+        payload[Policy::REPORT_SLEEP_BYTE] |= Policy::REPORT_SLEEP_MASK;
     }
 
     /* XFAN --------------------------------------------------------------------------- */
     if (this->xfan_state_)
     {
-        payload[protocol::REPORT_XFAN_BYTE] |= protocol::REPORT_XFAN_MASK;
+        payload[Policy::REPORT_XFAN_BYTE] |= Policy::REPORT_XFAN_MASK;
     }
 
     /* POWERSAVE --------------------------------------------------------------------------- */
     if (this->powersave_state_)
     {
-        payload[protocol::REPORT_POWERSAVE_BYTE] |= protocol::REPORT_POWERSAVE_MASK;
+        payload[Policy::REPORT_POWERSAVE_BYTE] |= Policy::REPORT_POWERSAVE_MASK;
     }
 
     /* IFEEL --------------------------------------------------------------------------- */
     if (this->ifeel_state_)
     {
-        payload[protocol::REPORT_IFEEL_BYTE] |= protocol::REPORT_IFEEL_MASK;
+        payload[Policy::REPORT_IFEEL_BYTE] |= Policy::REPORT_IFEEL_MASK;
+        /* the unit applies it with the command update_ifeel_temperature() asked for */
+        static_assert(Policy::SET_IFEEL_TEMP_BYTE == FIELD_UNKNOWN || Policy::SET_IFEEL_TEMP_BYTE < Policy::SET_PACKET_LEN,
+                      "iFeel temperature byte outside of the SET frame");
+        if constexpr (Policy::SET_IFEEL_TEMP_BYTE != FIELD_UNKNOWN)
+        {
+            if (!std::isnan(this->ifeel_temperature_))
+            {
+                payload[Policy::SET_IFEEL_TEMP_BYTE] = (uint8_t)clamp(lroundf(this->ifeel_temperature_) + Policy::SET_IFEEL_TEMP_OFF, 0L, 255L);
+            }
+        }
     }
 
     /* Do the command, length */
 
-    memcpy(this->lastpacket, payload, protocol::SET_PACKET_LEN);
-    
-    uint8_t full_packet[protocol::SET_PACKET_LEN + 5];
-    full_packet[0] = protocol::SYNC;
-    full_packet[1] = protocol::SYNC;
-    full_packet[2] = protocol::SET_PACKET_LEN + 2;
-    full_packet[3] = protocol::CMD_OUT_PARAMS_SET;
-    memcpy(&full_packet[4], payload, protocol::SET_PACKET_LEN);
-
-    /* Do checksum - sum of all bytes except sync and checksum itself% 0x100 
-       the module would be realized by the fact that we are using uint8_t*/
-    uint8_t checksum = 0;
-    for (uint8_t i = 2 ; i < protocol::SET_PACKET_LEN + 4 ; i++)
-    {
-        checksum += full_packet[i];
-    }
-    full_packet[protocol::SET_PACKET_LEN + 4] = checksum;
+    memcpy(this->lastpacket, payload, Policy::SET_PACKET_LEN);
+    this->lastpacket_valid_ = true;
 
     //ESP_LOGV(TAG, "Stamp1: %lx", this->last_packet_sent_);
     this->last_packet_sent_ = millis();  /* Save the time when we sent the last packet */
     
     this->wait_response_ = true;
-    write_array(full_packet, sizeof(full_packet));                 /* Sent the packet by UART */
-    log_packet(full_packet, sizeof(full_packet), true);            /* Log uart for debug purposes */
-   
+#ifdef USE_GREE_AC_TRACE
+    if (this->update_ == ACUpdate::UpdateStart)
+    {
+        this->trace_record(TRACE_WIRE);
+    }
+#endif
+    write_frame(Policy::CMD_OUT_PARAMS_SET, payload, Policy::SET_PACKET_LEN);
 
-    
     /* update setting state-machine */
     switch(this->update_)
     {
@@ -510,16 +1379,236 @@ void GreeACCNT::send_packet()
     }
 }
 
+/*
+ * Local control - steers the unit setpoint or fan from current_temperature_sensor through the normal SET path.
+ * The drive runs from -1 (back off) to 1 (full cooling or heating) and is evaluated once per update_interval,
+ * a changed output goes to the unit at most once per min_command_interval.
+ */
+template<typename Policy>
+void GreeACCNTEngine<Policy>::update_local_control()
+{
+    /* a command still on its way is not disturbed, the step is taken once it went out */
+    if (this->local_control_.algorithm == LocalControl::None || this->update_ != ACUpdate::NoUpdate ||
+        millis() - this->control_last_step_ < this->local_control_.update_interval ||
+        (this->local_control_.output == LocalControlOutput::Fan && this->control_fan_suspended_))
+    {
+        return;
+    }
+    float dt = (millis() - this->control_last_step_) / 1000.0f;
+    bool first_step = this->control_last_step_ == 0;
+    this->control_last_step_ = millis();
+
+    float temperature = this->current_temperature_sensor_ != nullptr ? this->current_temperature_sensor_->state : NAN;
+    if (this->state_ != ACState::Ready || std::isnan(temperature) ||
+        std::isnan(this->target_temperature) ||
+        (this->mode != climate::CLIMATE_MODE_COOL && this->mode != climate::CLIMATE_MODE_HEAT))
+    {
+        release_local_control();
+        return;
+    }
+
+    /* positive error - room needs more cooling or heating */
+    float error = this->mode == climate::CLIMATE_MODE_COOL ? temperature - this->target_temperature
+                                                          : this->target_temperature - temperature;
+    if (this->local_control_.algorithm == LocalControl::Hysteresis)
+    {
+        if (error > this->local_control_.hysteresis)
+            this->control_drive_ = 1;
+        else if (error < -this->local_control_.hysteresis)
+            this->control_drive_ = -1;
+    }
+    else
+    {
+        float integral = this->control_integral_ + (first_step ? 0 : this->local_control_.ki * error * dt);
+        float drive = this->local_control_.kp * error + integral;
+        /* anti-windup - keep the integral only while the output is not saturated */
+        if (drive > -1 && drive < 1)
+            this->control_integral_ = integral;
+        this->control_drive_ = clamp(drive, -1.0f, 1.0f);
+    }
+
+    if (millis() - this->control_last_command_ < this->local_control_.min_command_interval && this->control_last_command_ != 0)
+    {
+        return;
+    }
+
+    if (this->local_control_.output == LocalControlOutput::Setpoint)
+    {
+        float offset = this->control_drive_ * this->local_control_.max_offset;
+        float setpoint = round(this->mode == climate::CLIMATE_MODE_COOL ? this->target_temperature - offset
+                                                                       : this->target_temperature + offset);
+        setpoint = clamp<float>(setpoint, GreeAC::MIN_TEMPERATURE, GreeAC::MAX_TEMPERATURE);
+        if (setpoint == round(unit_target_temperature()))
+            return;
+        ESP_LOGD(TAG, "Local control: error %.2f, drive %.2f, unit setpoint %.0f", error, this->control_drive_, setpoint);
+        this->unit_setpoint_prev_ = unit_target_temperature();
+        this->unit_setpoint_ = setpoint;
+    }
+    else
+    {
+        static const char *const FAN_STEPS[] = {fan_modes::FAN_MIN, fan_modes::FAN_LOW, fan_modes::FAN_MED,
+                                                fan_modes::FAN_HIGH, fan_modes::FAN_MAX};
+        const char *fan_mode = FAN_STEPS[(int)round((this->control_drive_ + 1) * 2)];
+        if (this->has_custom_fan_mode() && this->get_custom_fan_mode() == fan_mode)
+            return;
+        if (!this->control_fan_owned_)
+        {
+            this->control_user_fan_ = this->has_custom_fan_mode() ? this->get_custom_fan_mode() : nullptr;
+            this->control_fan_owned_ = true;
+        }
+        ESP_LOGD(TAG, "Local control: error %.2f, drive %.2f, fan %s", error, this->control_drive_, fan_mode);
+        this->set_custom_fan_mode_(fan_mode);
+        this->publish_state();
+    }
+
+    this->control_last_command_ = millis();
+    this->update_ = ACUpdate::UpdateStart;
+}
+
+/* hand the setpoint and the fan back to the user and forget the controller history */
+template<typename Policy>
+void GreeACCNTEngine<Policy>::release_local_control()
+{
+    if (!std::isnan(this->unit_setpoint_))
+    {
+        /* the unit still runs on our setpoint - send the target */
+        this->update_ = ACUpdate::UpdateStart;
+    }
+    if (this->control_fan_owned_)
+    {
+        this->control_fan_owned_ = false;
+        if (this->control_user_fan_ != nullptr)
+        {
+            ESP_LOGD(TAG, "Local control: fan back to %s", this->control_user_fan_);
+            this->set_custom_fan_mode_(this->control_user_fan_);
+            this->update_ = ACUpdate::UpdateStart;
+            this->publish_state();
+        }
+    }
+    this->unit_setpoint_prev_ = this->unit_setpoint_;
+    this->unit_setpoint_ = NAN;
+    this->control_integral_ = 0;
+    this->control_drive_ = 0;
+}
+
+/*
+ * iFeel - the forwarded room temperature follows the external sensor past the deadband, at most once per interval,
+ * so the unit does not chase sensor noise. Returns true if the forwarded value changed.
+ */
+template<typename Policy>
+bool GreeACCNTEngine<Policy>::update_ifeel_temperature()
+{
+    if (Policy::SET_IFEEL_TEMP_BYTE == FIELD_UNKNOWN || !this->ifeel_forwarding_ || this->current_temperature_sensor_ == nullptr)
+    {
+        return false;
+    }
+
+    float temperature = this->current_temperature_sensor_->state;
+    if (this->current_temperature_sensor_->has_state() && !std::isnan(temperature) &&
+        (std::isnan(this->ifeel_temperature_) ||
+         (std::fabs(temperature - this->ifeel_temperature_) >= this->ifeel_deadband_ &&
+          millis() - this->ifeel_updated_ >= this->ifeel_interval_)))
+    {
+        ESP_LOGD(TAG, "Forwarding room temperature %.1f to the unit", temperature);
+        this->ifeel_temperature_ = temperature;
+        this->ifeel_updated_ = millis();
+        return true;
+    }
+
+    return false;
+}
+
+/*
+ * Extended telemetry - 0x33 / 0x44 frames feed the configured sensors, each at its own pace
+ */
+
+template<typename Policy>
+bool GreeACCNTEngine<Policy>::is_telemetry_packet()
+{
+    if (this->serialProcess_.data.size() < 5)
+    {
+        return false;
+    }
+    uint8_t command = this->serialProcess_.data[3];
+    return command == Policy::CMD_IN_UNKNOWN_1 || command == Policy::CMD_IN_UNKNOWN_2;
+}
+
+template<typename Policy>
+void GreeACCNTEngine<Policy>::handle_telemetry_packet()
+{
+    const std::vector<uint8_t> &data = this->serialProcess_.data;
+    const uint8_t command = data[3];
+    const uint32_t now = millis();
+
+    /* checksum only when some sensor wants a sample from this frame */
+    bool checked = false;
+    for (Telemetry_t &telemetry : this->telemetry_)
+    {
+        if (telemetry.command != command ||
+            (telemetry.last_sample != 0 && now - telemetry.last_sample < telemetry.sampling_interval))
+        {
+            continue;
+        }
+
+        if (!checked)
+        {
+            if (Policy::checksum(data.data(), data.size()) != data[data.size() - 1])
+            {
+                ESP_LOGD(TAG, "Dropping invalid telemetry packet (checksum)");
+                this->counters_[COUNTER_CHECKSUM_ERRORS]++;
+                link_frame(false);
+                return;
+            }
+            link_frame(true);
+            checked = true;
+        }
+
+        if (telemetry.byte + 5u > data.size())
+        {
+            ESP_LOGW(TAG, "Telemetry byte %u outside of %02X frame", telemetry.byte, command);
+            continue;
+        }
+        telemetry.last_sample = now;
+
+        uint8_t raw = data[telemetry.byte + 4] & telemetry.mask;
+        if (telemetry.mask != 0)
+        {
+            for (uint8_t mask = telemetry.mask; (mask & 1) == 0; mask >>= 1)
+            {
+                raw >>= 1;
+            }
+        }
+        float value = raw * telemetry.multiplier + telemetry.offset;
+
+        if (telemetry.published)
+        {
+            if (now - telemetry.last_publish < telemetry.publish_interval ||
+                fabsf(value - telemetry.last_value) < telemetry.delta)
+            {
+                continue;
+            }
+        }
+        telemetry.published = true;
+        telemetry.last_publish = now;
+        telemetry.last_value = value;
+        telemetry.sensor->publish_state(value);
+    }
+}
+
 /*
  * Packet handling
  */
 
-bool GreeACCNT::verify_packet()
+template<typename Policy>
+bool GreeACCNTEngine<Policy>::verify_packet()
 {
+    GREE_AC_PROFILE(PHASE_VERIFY);
+
     /* At least 2 sync bytes + length + type + checksum */
     if (this->serialProcess_.data.size() < 5)
     {
         ESP_LOGW(TAG, "Dropping invalid packet (length)");
+        link_frame(false);
         return false;
     }
 
@@ -528,103 +1617,220 @@ bool GreeACCNT::verify_packet()
     /* The frame len was assumed by GreeAC::read_data() */
 
     /* Check if this packet type sould be processed */
-    bool commandAllowed = false;
-    for (uint8_t packet : ALLOWED_PACKETS)
-    {
-        if (this->serialProcess_.data[3] == packet)
-        {
-            commandAllowed = true;
-            break;
-        }
-    }
-    if (!commandAllowed)
+    if (this->serialProcess_.data[3] != Policy::CMD_IN_UNIT_REPORT)
     {
         ESP_LOGW(TAG, "Dropping invalid packet (command [%02X] not allowed)", this->serialProcess_.data[3]);
+        this->counters_[COUNTER_DISALLOWED_COMMANDS]++;
         return false;
     }
 
-    /* Check checksum - sum of all bytes except sync and checksum itself% 0x100 
-       the module would be realized by the fact that we are using uint8_t*/
-    uint8_t checksum = 0;
-    for (uint8_t i = 2 ; i < this->serialProcess_.data.size() - 1 ; i++)
-    {
-        checksum += this->serialProcess_.data[i];
-    }
+    /* Check checksum */
+    uint8_t checksum = Policy::checksum(this->serialProcess_.data.data(), this->serialProcess_.data.size());
     if (checksum != this->serialProcess_.data[this->serialProcess_.data.size()-1])
     {
         ESP_LOGD(TAG, "Dropping invalid packet (checksum)");
+        this->counters_[COUNTER_CHECKSUM_ERRORS]++;
+        link_frame(false);
         return false;
     }
 
+    link_frame(true);
     return true;
 }
 
-void GreeACCNT::handle_packet()
+template<typename Policy>
+void GreeACCNTEngine<Policy>::handle_packet()
 {
-    if (this->serialProcess_.data[3] == protocol::CMD_IN_UNIT_REPORT)
+    if (this->serialProcess_.data[3] == Policy::CMD_IN_UNIT_REPORT)
     {
         /* here we will remove unnecessary elements - header and checksum */
         this->serialProcess_.data.erase(this->serialProcess_.data.begin(), this->serialProcess_.data.begin() + 4); /* remove header */
         this->serialProcess_.data.pop_back();  /* remove checksum */
 
+        /* optimistic state was published - do not overwrite it with a report that predates our command */
+        bool holdRequest = false;
+        if (this->optimistic_request_.pending)
+        {
+            if (this->report_confirms_request())
+            {
+                ESP_LOGV(TAG, "Unit confirmed requested state");
+                this->optimistic_request_.pending = false;
+            }
+            else if (millis() - this->optimistic_request_.since < protocol::TIME_OPTIMISTIC_CONFIRM_MS)
+            {
+                ESP_LOGV(TAG, "Report does not confirm requested state yet, keeping requested fields");
+                holdRequest = true;
+            }
+            else
+            {
+                ESP_LOGD(TAG, "Unit did not accept requested state, rolling back");
+                this->optimistic_request_.pending = false;
+            }
+        }
+
+#ifdef USE_GREE_AC_TRACE
+        if (this->trace_stage_ == TRACE_WIRE)
+        {
+            this->trace_record(TRACE_CONFIRM);
+        }
+#endif
+
         /* now process the data */
-        bool hasChanged = this->processUnitReport();
+        bool hasChanged = this->processUnitReport(holdRequest);
+        queue_state_save();
+        this->update_runtime(this->link_.inactive_timeout);
 
         // Detect if AC state differs from what we last sent (indicates remote change)
         bool remoteChanged = false;
-        for (uint8_t i : BYTES_TO_CHECK)
+        /* nothing sent yet - no base to compare with */
+        if (this->lastpacket_valid_)
         {
-            if (i < 45) {
-                uint8_t last = lastpacket[i];
-                uint8_t current = this->serialProcess_.data[i];
-                if (i == protocol::SET_NOCHANGE_BYTE) {
-                    last &= ~protocol::SET_NOCHANGE_MASK;
-                    current &= ~protocol::SET_NOCHANGE_MASK;
-                }
-                if (last != current) {
-                    remoteChanged = true;
-                    break;
+            for (uint8_t i : Policy::REPORT_CHANGE_BYTES)
+            {
+                if (i < Policy::SET_PACKET_LEN) {
+                    uint8_t last = lastpacket[i];
+                    uint8_t current = this->serialProcess_.data[i];
+                    if (i == Policy::SET_NOCHANGE_BYTE) {
+                        last &= ~Policy::SET_NOCHANGE_MASK;
+                        current &= ~Policy::SET_NOCHANGE_MASK;
+                    }
+                    if (last != current) {
+                        remoteChanged = true;
+                        break;
+                    }
                 }
             }
         }
 
-        if (hasChanged || remoteChanged || reqmodechange)
+        if (hasChanged || remoteChanged || reqmodechange || !this->synced_)
         {
-            ESP_LOGD(TAG, "State update: hasChanged=%d, remoteChanged=%d, reqmodechange=%d", hasChanged, remoteChanged, reqmodechange);
-            this->publish_state();
+#if ESPHOME_LOG_LEVEL >= ESPHOME_LOG_LEVEL_DEBUG
+            /* a repeat means the same flags for the same decoded state, any other report is logged */
+            uint8_t state[sizeof(Policy::REPORT_CHANGE_BYTES) + 3] = {hasChanged, remoteChanged, reqmodechange};
+            for (uint8_t n = 0; n < sizeof(Policy::REPORT_CHANGE_BYTES); n++)
+            {
+                uint8_t i = Policy::REPORT_CHANGE_BYTES[n];
+                state[n + 3] = i < this->serialProcess_.data.size() ? this->serialProcess_.data[i] : 0;
+            }
+            if (this->log_gate(this->state_log_, GreeAC::log_hash(state, sizeof(state))))
+                ESP_LOGD(TAG, "State update: hasChanged=%d, remoteChanged=%d, reqmodechange=%d", hasChanged, remoteChanged, reqmodechange);
+#endif
+            {
+                GREE_AC_PROFILE(PHASE_PUBLISH);
+                this->publish_state();
+            }
+            this->sample_memory();
             reqmodechange = false;
+#ifdef USE_GREE_AC_TRACE
+            if (this->trace_stage_ == TRACE_CONFIRM)
+            {
+                this->trace_record(TRACE_PUBLISH);
+            }
+#endif
+        }
+
+#ifdef USE_GREE_AC_TRACE
+        if (this->trace_stage_ == TRACE_CONFIRM || this->trace_stage_ == TRACE_PUBLISH)
+        {
+            this->trace_record(TRACE_DONE, 1);
+        }
+#endif
+
+        if (!this->synced_)
+        {
+            this->synced_ = true;
+            uint32_t startup_time = millis();
+            ESP_LOGI(TAG, "First state published %" PRIu32 " ms after power-on", startup_time);
+            if (this->startup_time_sensor_ != nullptr)
+            {
+                this->startup_time_sensor_->publish_state(startup_time);
+            }
         }
 
     }
     else 
     {
-        ESP_LOGD(TAG, "Received unknown packet type: 0x%02X", this->serialProcess_.data[3]);
+#if ESPHOME_LOG_LEVEL >= ESPHOME_LOG_LEVEL_DEBUG
+        if (this->log_gate(this->state_log_, GreeAC::log_hash(&this->serialProcess_.data[3], 1)))
+            ESP_LOGD(TAG, "Received unknown packet type: 0x%02X", this->serialProcess_.data[3]);
+#endif
     }
 }
 
+/*
+ * Check if report (header and checksum already removed) shows state we published optimistically
+ */
+template<typename Policy>
+bool GreeACCNTEngine<Policy>::report_confirms_request()
+{
+    /* decoded without storing anything, processUnitReport() does that once the report is accepted */
+    climate::ClimateMode mode = decode_power() ? decode_mode_internal() : climate::CLIMATE_MODE_OFF;
+    if (mode != this->optimistic_request_.mode)
+        return false;
+
+    uint8_t temset = (this->serialProcess_.data[Policy::REPORT_TEMP_SET_BYTE] & Policy::REPORT_TEMP_SET_MASK) >> Policy::REPORT_TEMP_SET_POS;
+    float expected = std::isnan(this->unit_setpoint_) ? this->optimistic_request_.target_temperature : this->unit_setpoint_;
+    if ((float)(temset + Policy::REPORT_TEMP_SET_OFF) != round(expected))
+        return false;
+
+    if (this->optimistic_request_.fan_mode != nullptr && strcmp(determine_fan_mode(false), this->optimistic_request_.fan_mode) != 0)
+        return false;
+
+    return determine_swing_mode(determine_vertical_swing(false), determine_horizontal_swing(false)) == this->optimistic_request_.swing_mode;
+}
+
 /*
  * This decodes frame recieved from AC Unit
+ * hold_request keeps the optimistically published mode, target, fan and swing until the unit confirms them
  */
-bool GreeACCNT::processUnitReport()
+template<typename Policy>
+bool GreeACCNTEngine<Policy>::processUnitReport(bool hold_request)
 {
+    GREE_AC_PROFILE(PHASE_DECODE);
+
     bool hasChanged = false;
 
-    climate::ClimateMode newMode = determine_mode();
-    if (this->mode != newMode) {
-        this->mode = newMode;
-        hasChanged = true;
-    }
+    if (!hold_request)
+    {
+        climate::ClimateMode newMode = determine_mode();
+        if (this->mode != newMode) {
+            this->mode = newMode;
+            hasChanged = true;
+        }
 
-    const char* newFanMode = determine_fan_mode();
-    if (!this->has_custom_fan_mode() || this->get_custom_fan_mode() != newFanMode) {
-        this->set_custom_fan_mode_(newFanMode);
-        hasChanged = true;
+        const char* newFanMode = determine_fan_mode();
+        if (!this->has_custom_fan_mode() || this->get_custom_fan_mode() != newFanMode) {
+            this->set_custom_fan_mode_(newFanMode);
+            hasChanged = true;
+        }
     }
     
-    uint8_t temset = (this->serialProcess_.data[protocol::REPORT_TEMP_SET_BYTE] & protocol::REPORT_TEMP_SET_MASK) >> protocol::REPORT_TEMP_SET_POS;
-    float newTargetTemperature = (float)(temset + protocol::REPORT_TEMP_SET_OFF);
+    uint8_t temset = (this->serialProcess_.data[Policy::REPORT_TEMP_SET_BYTE] & Policy::REPORT_TEMP_SET_MASK) >> Policy::REPORT_TEMP_SET_POS;
+    float newTargetTemperature = (float)(temset + Policy::REPORT_TEMP_SET_OFF);
 
-    if (this->target_temperature != newTargetTemperature)
+    if (hold_request)
+    {
+        /* requested target stays published */
+    }
+    else if (this->control_adopt_setpoint_)
+    {
+        /* first report after a restart - whatever the unit runs on came from local control */
+        this->control_adopt_setpoint_ = false;
+        this->unit_setpoint_ = newTargetTemperature;
+        this->unit_setpoint_prev_ = newTargetTemperature;
+    }
+    else if (!std::isnan(this->unit_setpoint_))
+    {
+        /* local control owns the unit setpoint - only a value we never sent was set by the remote */
+        if (newTargetTemperature != round(this->unit_setpoint_) && newTargetTemperature != round(this->unit_setpoint_prev_))
+        {
+            ESP_LOGD(TAG, "Setpoint changed on the unit, local control starts over");
+            release_local_control();
+            this->target_temperature = newTargetTemperature;
+            hasChanged = true;
+        }
+    }
+    else if (this->target_temperature != newTargetTemperature)
     {
         this->target_temperature = newTargetTemperature;
         hasChanged = true;
@@ -633,38 +1839,32 @@ bool GreeACCNT::processUnitReport()
     /* if there is no external sensor mapped to represent current temperature we will get data from AC unit */
     if (this->current_temperature_sensor_ == nullptr)
     {
-        float newCurrentTemperature = (float)(this->serialProcess_.data[protocol::REPORT_TEMP_ACT_BYTE] - protocol::REPORT_TEMP_ACT_OFF);
+        float newCurrentTemperature = (float)(this->serialProcess_.data[Policy::REPORT_TEMP_ACT_BYTE] - Policy::REPORT_TEMP_ACT_OFF);
         if (this->current_temperature != newCurrentTemperature) {
             this->current_temperature = newCurrentTemperature;
             hasChanged = true;
         }
     }
 
-    const char* verticalSwing = determine_vertical_swing();
-    if (this->vertical_swing_state_ != verticalSwing) {
-        this->update_swing_vertical(verticalSwing);
-        hasChanged = true;
-    }
+    if (!hold_request)
+    {
+        const char* verticalSwing = determine_vertical_swing();
+        if (this->vertical_swing_state_ != verticalSwing) {
+            this->update_swing_vertical(verticalSwing);
+            hasChanged = true;
+        }
 
-    const char* horizontalSwing = determine_horizontal_swing();
-    if (this->horizontal_swing_state_ != horizontalSwing) {
-        this->update_swing_horizontal(horizontalSwing);
-        hasChanged = true;
-    }
+        const char* horizontalSwing = determine_horizontal_swing();
+        if (this->horizontal_swing_state_ != horizontalSwing) {
+            this->update_swing_horizontal(horizontalSwing);
+            hasChanged = true;
+        }
 
-    climate::ClimateSwingMode newSwingMode;
-    if (strcmp(verticalSwing, vertical_swing_options::FULL) == 0 && strcmp(horizontalSwing, horizontal_swing_options::FULL) == 0)
-        newSwingMode = climate::CLIMATE_SWING_BOTH;
-    else if (strcmp(verticalSwing, vertical_swing_options::FULL) == 0)
-        newSwingMode = climate::CLIMATE_SWING_VERTICAL;
-    else if (strcmp(horizontalSwing, horizontal_swing_options::FULL) == 0)
-        newSwingMode = climate::CLIMATE_SWING_HORIZONTAL;
-    else
-        newSwingMode = climate::CLIMATE_SWING_OFF;
-    
-    if (this->swing_mode != newSwingMode) {
-        this->swing_mode = newSwingMode;
-        hasChanged = true;
+        climate::ClimateSwingMode newSwingMode = determine_swing_mode(verticalSwing, horizontalSwing);
+        if (this->swing_mode != newSwingMode) {
+            this->swing_mode = newSwingMode;
+            hasChanged = true;
+        }
     }
 
     const char* display = determine_display();
@@ -736,37 +1936,16 @@ bool GreeACCNT::processUnitReport()
     return hasChanged;
 }
 
-climate::ClimateMode GreeACCNT::determine_mode()
+template<typename Policy>
+climate::ClimateMode GreeACCNTEngine<Policy>::determine_mode()
 {
-    uint8_t mode = (this->serialProcess_.data[protocol::REPORT_MODE_BYTE] & protocol::REPORT_MODE_MASK) >> protocol::REPORT_MODE_POS;
-
     /* as mode presented by climate component incorporates both power and mode we will store this separately for Gree
        in _internal_ fields */
-    /* check unit power flag */
-    this->power_internal_ = (this->serialProcess_.data[protocol::REPORT_PWR_BYTE] & protocol::REPORT_PWR_MASK) != 0;
-
-    /* check unit mode */
-    switch (mode)
+    this->power_internal_ = decode_power();
+    this->mode_internal_ = decode_mode_internal();
+    if (this->mode_internal_ == climate::CLIMATE_MODE_OFF)
     {
-        case protocol::REPORT_MODE_AUTO:
-            this->mode_internal_ = climate::CLIMATE_MODE_AUTO;
-            break;
-        case protocol::REPORT_MODE_COOL:
-            this->mode_internal_ = climate::CLIMATE_MODE_COOL;
-            break;
-        case protocol::REPORT_MODE_DRY:
-            this->mode_internal_ = climate::CLIMATE_MODE_DRY;
-            break;
-        case protocol::REPORT_MODE_FAN:
-            this->mode_internal_ = climate::CLIMATE_MODE_FAN_ONLY;
-            break;
-        case protocol::REPORT_MODE_HEAT:
-            this->mode_internal_ = climate::CLIMATE_MODE_HEAT;
-            break;
-        default:
-            ESP_LOGW(TAG, "Received unknown climate mode");
-            this->mode_internal_ = climate::CLIMATE_MODE_OFF;
-            break;
+        ESP_LOGW(TAG, "Received unknown climate mode");
     }
 
     /* if unit is powered on - return the mode, otherwise return CLIMATE_MODE_OFF */
@@ -780,10 +1959,43 @@ climate::ClimateMode GreeACCNT::determine_mode()
     }
 }
 
-const char* GreeACCNT::determine_fan_mode()
+template<typename Policy>
+bool GreeACCNTEngine<Policy>::decode_power()
+{
+    /* check unit power flag */
+    return (this->serialProcess_.data[Policy::REPORT_PWR_BYTE] & Policy::REPORT_PWR_MASK) != 0;
+}
+
+/*
+ * Mode bits of the report regardless of power, CLIMATE_MODE_OFF if unknown
+ */
+template<typename Policy>
+climate::ClimateMode GreeACCNTEngine<Policy>::decode_mode_internal()
+{
+    uint8_t mode = (this->serialProcess_.data[Policy::REPORT_MODE_BYTE] & Policy::REPORT_MODE_MASK) >> Policy::REPORT_MODE_POS;
+
+    switch (mode)
+    {
+        case Policy::REPORT_MODE_AUTO:
+            return climate::CLIMATE_MODE_AUTO;
+        case Policy::REPORT_MODE_COOL:
+            return climate::CLIMATE_MODE_COOL;
+        case Policy::REPORT_MODE_DRY:
+            return climate::CLIMATE_MODE_DRY;
+        case Policy::REPORT_MODE_FAN:
+            return climate::CLIMATE_MODE_FAN_ONLY;
+        case Policy::REPORT_MODE_HEAT:
+            return climate::CLIMATE_MODE_HEAT;
+        default:
+            return climate::CLIMATE_MODE_OFF;
+    }
+}
+
+template<typename Policy>
+const char* GreeACCNTEngine<Policy>::determine_fan_mode(bool warn)
 {
     /* fan setting has quite complex representation in the packet, brace for it */
-    uint8_t fan_mode = (this->serialProcess_.data[protocol::REPORT_FAN_SPD1_BYTE] & protocol::REPORT_FAN_SPD1_MASK);
+    uint8_t fan_mode = (this->serialProcess_.data[Policy::REPORT_FAN_SPD1_BYTE] & Policy::REPORT_FAN_SPD1_MASK);
 
     if (fan_mode == 0x08)
         return fan_modes::FAN_AUTO;
@@ -799,81 +2011,103 @@ const char* GreeACCNT::determine_fan_mode()
         return fan_modes::FAN_MAX;
     else
     {
-        ESP_LOGW(TAG, "Received unknown fan mode: %d", fan_mode);
+        if (warn)
+            ESP_LOGW(TAG, "Received unknown fan mode: %d", fan_mode);
         return fan_modes::FAN_AUTO;
     }
 }
 
-const char* GreeACCNT::determine_vertical_swing()
+template<typename Policy>
+const char* GreeACCNTEngine<Policy>::determine_vertical_swing(bool warn)
 {
-    uint8_t mode = (this->serialProcess_.data[protocol::REPORT_VSWING_BYTE]  & protocol::REPORT_VSWING_MASK) >> protocol::REPORT_VSWING_POS;
+    uint8_t mode = (this->serialProcess_.data[Policy::REPORT_VSWING_BYTE]  & Policy::REPORT_VSWING_MASK) >> Policy::REPORT_VSWING_POS;
 
     switch (mode) {
-        case protocol::REPORT_VSWING_OFF:
+        case Policy::REPORT_VSWING_OFF:
             return vertical_swing_options::OFF;
-        case protocol::REPORT_VSWING_FULL:
+        case Policy::REPORT_VSWING_FULL:
             return vertical_swing_options::FULL;
-        case protocol::REPORT_VSWING_CUP:
+        case Policy::REPORT_VSWING_CUP:
             return vertical_swing_options::CUP;
-        case protocol::REPORT_VSWING_CMIDU:
+        case Policy::REPORT_VSWING_CMIDU:
             return vertical_swing_options::CMIDU;
-        case protocol::REPORT_VSWING_CMID:
+        case Policy::REPORT_VSWING_CMID:
             return vertical_swing_options::CMID;
-        case protocol::REPORT_VSWING_CMIDD:
+        case Policy::REPORT_VSWING_CMIDD:
             return vertical_swing_options::CMIDD;
-        case protocol::REPORT_VSWING_CDOWN:
+        case Policy::REPORT_VSWING_CDOWN:
             return vertical_swing_options::CDOWN;
-        case protocol::REPORT_VSWING_DOWN:
+        case Policy::REPORT_VSWING_DOWN:
             return vertical_swing_options::DOWN;
-        case protocol::REPORT_VSWING_MIDD:
+        case Policy::REPORT_VSWING_MIDD:
             return vertical_swing_options::MIDD;
-        case protocol::REPORT_VSWING_MID:
+        case Policy::REPORT_VSWING_MID:
             return vertical_swing_options::MID;
-        case protocol::REPORT_VSWING_MIDU:
+        case Policy::REPORT_VSWING_MIDU:
             return vertical_swing_options::MIDU;
-        case protocol::REPORT_VSWING_UP:
+        case Policy::REPORT_VSWING_UP:
             return vertical_swing_options::UP;
         default:
-            ESP_LOGW(TAG, "Received unknown vertical swing mode");
+            if (warn)
+                ESP_LOGW(TAG, "Received unknown vertical swing mode");
             return vertical_swing_options::OFF;
     }
 }
 
-const char* GreeACCNT::determine_horizontal_swing()
+template<typename Policy>
+const char* GreeACCNTEngine<Policy>::determine_horizontal_swing(bool warn)
 {
-    uint8_t mode = (this->serialProcess_.data[protocol::REPORT_HSWING_BYTE]  & protocol::REPORT_HSWING_MASK) >> protocol::REPORT_HSWING_POS;
+    uint8_t mode = (this->serialProcess_.data[Policy::REPORT_HSWING_BYTE]  & Policy::REPORT_HSWING_MASK) >> Policy::REPORT_HSWING_POS;
 
     switch (mode) {
-        case protocol::REPORT_HSWING_OFF:
+        case Policy::REPORT_HSWING_OFF:
             return horizontal_swing_options::OFF;
-        case protocol::REPORT_HSWING_FULL:
+        case Policy::REPORT_HSWING_FULL:
             return horizontal_swing_options::FULL;
-        case protocol::REPORT_HSWING_CLEFT:
+        case Policy::REPORT_HSWING_CLEFT:
             return horizontal_swing_options::CLEFT;
-        case protocol::REPORT_HSWING_CMIDL:
+        case Policy::REPORT_HSWING_CMIDL:
             return horizontal_swing_options::CMIDL;
-        case protocol::REPORT_HSWING_CMID:
+        case Policy::REPORT_HSWING_CMID:
             return horizontal_swing_options::CMID;
-        case protocol::REPORT_HSWING_CMIDR:
+        case Policy::REPORT_HSWING_CMIDR:
             return horizontal_swing_options::CMIDR;
-        case protocol::REPORT_HSWING_CRIGHT:
+        case Policy::REPORT_HSWING_CRIGHT:
             return horizontal_swing_options::CRIGHT;
         default:
-            ESP_LOGW(TAG, "Received unknown horizontal swing mode");
+            if (warn)
+                ESP_LOGW(TAG, "Received unknown horizontal swing mode");
             return horizontal_swing_options::OFF;
     }
 }
 
-const char* GreeACCNT::determine_display()
+template<typename Policy>
+climate::ClimateSwingMode GreeACCNTEngine<Policy>::determine_swing_mode(const char *vertical_swing, const char *horizontal_swing)
+{
+    bool vertical_full = strcmp(vertical_swing, vertical_swing_options::FULL) == 0;
+    bool horizontal_full = strcmp(horizontal_swing, horizontal_swing_options::FULL) == 0;
+
+    if (vertical_full && horizontal_full)
+        return climate::CLIMATE_SWING_BOTH;
+    else if (vertical_full)
+        return climate::CLIMATE_SWING_VERTICAL;
+    else if (horizontal_full)
+        return climate::CLIMATE_SWING_HORIZONTAL;
+    else
+        return climate::CLIMATE_SWING_OFF;
+}
+
+template<typename Policy>
+const char* GreeACCNTEngine<Policy>::determine_display()
 {
-    uint8_t mode = (this->serialProcess_.data[protocol::REPORT_DISP_MODE_BYTE] & protocol::REPORT_DISP_MODE_MASK) >> protocol::REPORT_DISP_MODE_POS;
+    uint8_t mode = (this->serialProcess_.data[Policy::REPORT_DISP_MODE_BYTE] & Policy::REPORT_DISP_MODE_MASK) >> Policy::REPORT_DISP_MODE_POS;
 
     switch (mode) {
-        case protocol::REPORT_DISP_MODE_SET:
+        case Policy::REPORT_DISP_MODE_SET:
             return display_options::SET;
-        case protocol::REPORT_DISP_MODE_ACT:
+        case Policy::REPORT_DISP_MODE_ACT:
             return display_options::ACT;
-        case protocol::REPORT_DISP_MODE_OUT:
+        case Policy::REPORT_DISP_MODE_OUT:
             ESP_LOGW(TAG, "Outside temperature display mode is not supported and was requested by the unit. Falling back to Set temperature.");
             return display_options::SET;
         default:
@@ -881,14 +2115,16 @@ const char* GreeACCNT::determine_display()
     }
 }
 
-bool GreeACCNT::determine_light()
+template<typename Policy>
+bool GreeACCNTEngine<Policy>::determine_light()
 {
-    return (this->serialProcess_.data[protocol::REPORT_DISP_ON_BYTE] & protocol::REPORT_DISP_ON_MASK) != 0;
+    return (this->serialProcess_.data[Policy::REPORT_DISP_ON_BYTE] & Policy::REPORT_DISP_ON_MASK) != 0;
 }
 
-const char* GreeACCNT::determine_display_unit()
+template<typename Policy>
+const char* GreeACCNTEngine<Policy>::determine_display_unit()
 {
-    if (this->serialProcess_.data[protocol::REPORT_DISP_F_BYTE] & protocol::REPORT_DISP_F_MASK)
+    if (this->serialProcess_.data[Policy::REPORT_DISP_F_BYTE] & Policy::REPORT_DISP_F_MASK)
     {
         return display_unit_options::DEGF;
     }
@@ -898,40 +2134,48 @@ const char* GreeACCNT::determine_display_unit()
     }
 }
 
-bool GreeACCNT::determine_ionizer(){
-    bool ionizer1 = (this->serialProcess_.data[protocol::REPORT_IONIZER1_BYTE] & protocol::REPORT_IONIZER1_MASK) != 0;
-    bool ionizer2 = (this->serialProcess_.data[protocol::REPORT_IONIZER2_BYTE] & protocol::REPORT_IONIZER2_MASK) != 0;
+template<typename Policy>
+bool GreeACCNTEngine<Policy>::determine_ionizer(){
+    bool ionizer1 = (this->serialProcess_.data[Policy::REPORT_IONIZER1_BYTE] & Policy::REPORT_IONIZER1_MASK) != 0;
+    bool ionizer2 = (this->serialProcess_.data[Policy::REPORT_IONIZER2_BYTE] & Policy::REPORT_IONIZER2_MASK) != 0;
     return ionizer1 || ionizer2;
 }
 
-bool GreeACCNT::determine_beeper(){
-    return (this->serialProcess_.data[protocol::REPORT_BEEPER_BYTE] & protocol::REPORT_BEEPER_MASK) == 0;
+template<typename Policy>
+bool GreeACCNTEngine<Policy>::determine_beeper(){
+    return (this->serialProcess_.data[Policy::REPORT_BEEPER_BYTE] & Policy::REPORT_BEEPER_MASK) == 0;
 }
 
-bool GreeACCNT::determine_sleep(){
-    return (this->serialProcess_.data[protocol::REPORT_SLEEP_BYTE] & protocol::REPORT_SLEEP_MASK) != 0;
+template<typename Policy>
+bool GreeACCNTEngine<Policy>::determine_sleep(){
+    return (this->serialProcess_.data[Policy::REPORT_SLEEP_BYTE] & Policy::REPORT_SLEEP_MASK) != 0;
 }
 
-bool GreeACCNT::determine_xfan(){
-    return (this->serialProcess_.data[protocol::REPORT_XFAN_BYTE] & protocol::REPORT_XFAN_MASK) != 0;
+template<typename Policy>
+bool GreeACCNTEngine<Policy>::determine_xfan(){
+    return (this->serialProcess_.data[Policy::REPORT_XFAN_BYTE] & Policy::REPORT_XFAN_MASK) != 0;
 }
 
-bool GreeACCNT::determine_powersave(){
-    return (this->serialProcess_.data[protocol::REPORT_POWERSAVE_BYTE] & protocol::REPORT_POWERSAVE_MASK) != 0;
+template<typename Policy>
+bool GreeACCNTEngine<Policy>::determine_powersave(){
+    return (this->serialProcess_.data[Policy::REPORT_POWERSAVE_BYTE] & Policy::REPORT_POWERSAVE_MASK) != 0;
 }
 
-bool GreeACCNT::determine_turbo(){
-    return (this->serialProcess_.data[protocol::REPORT_FAN_TURBO_BYTE] & protocol::REPORT_FAN_TURBO_MASK) != 0;
+template<typename Policy>
+bool GreeACCNTEngine<Policy>::determine_turbo(){
+    return (this->serialProcess_.data[Policy::REPORT_FAN_TURBO_BYTE] & Policy::REPORT_FAN_TURBO_MASK) != 0;
 }
 
-bool GreeACCNT::determine_ifeel(){
-    return (this->serialProcess_.data[protocol::REPORT_IFEEL_BYTE] & protocol::REPORT_IFEEL_MASK) != 0;
+template<typename Policy>
+bool GreeACCNTEngine<Policy>::determine_ifeel(){
+    return (this->serialProcess_.data[Policy::REPORT_IFEEL_BYTE] & Policy::REPORT_IFEEL_MASK) != 0;
 }
 
-const char* GreeACCNT::determine_quiet(){
-    if (this->serialProcess_.data[protocol::REPORT_FAN_QUIET_BYTE] & protocol::REPORT_FAN_QUIET_MASK)
+template<typename Policy>
+const char* GreeACCNTEngine<Policy>::determine_quiet(){
+    if (this->serialProcess_.data[Policy::REPORT_FAN_QUIET_BYTE] & Policy::REPORT_FAN_QUIET_MASK)
         return quiet_options::ON;
-    if (this->serialProcess_.data[protocol::REPORT_FAN_QUIET_BYTE] & protocol::REPORT_FAN_QUIET_AUTO_MASK)
+    if (this->serialProcess_.data[Policy::REPORT_FAN_QUIET_BYTE] & Policy::REPORT_FAN_QUIET_AUTO_MASK)
         return quiet_options::AUTO;
     return quiet_options::OFF;
 }
@@ -941,9 +2185,10 @@ const char* GreeACCNT::determine_quiet(){
  * Sensor handling
  */
 
-void GreeACCNT::on_vertical_swing_change(const std::string &swing)
+template<typename Policy>
+void GreeACCNTEngine<Policy>::on_vertical_swing_change(const std::string &swing)
 {
-    if (this->state_ != ACState::Ready)
+    if (this->state_ != ACState::Ready || !this->tx_enabled_)
         return;
 
     ESP_LOGD(TAG, "Setting vertical swing position");
@@ -952,9 +2197,10 @@ void GreeACCNT::on_vertical_swing_change(const std::string &swing)
     this->vertical_swing_state_ = swing;
 }
 
-void GreeACCNT::on_horizontal_swing_change(const std::string &swing)
+template<typename Policy>
+void GreeACCNTEngine<Policy>::on_horizontal_swing_change(const std::string &swing)
 {
-    if (this->state_ != ACState::Ready)
+    if (this->state_ != ACState::Ready || !this->tx_enabled_)
         return;
 
     ESP_LOGD(TAG, "Setting horizontal swing position");
@@ -963,9 +2209,10 @@ void GreeACCNT::on_horizontal_swing_change(const std::string &swing)
     this->horizontal_swing_state_ = swing;
 }
 
-void GreeACCNT::on_display_change(const std::string &display)
+template<typename Policy>
+void GreeACCNTEngine<Policy>::on_display_change(const std::string &display)
 {
-    if (this->state_ != ACState::Ready)
+    if (this->state_ != ACState::Ready || !this->tx_enabled_)
         return;
 
     ESP_LOGD(TAG, "Setting display mode");
@@ -974,9 +2221,10 @@ void GreeACCNT::on_display_change(const std::string &display)
     this->display_state_ = display;
 }
 
-void GreeACCNT::on_display_unit_change(const std::string &display_unit)
+template<typename Policy>
+void GreeACCNTEngine<Policy>::on_display_unit_change(const std::string &display_unit)
 {
-    if (this->state_ != ACState::Ready)
+    if (this->state_ != ACState::Ready || !this->tx_enabled_)
         return;
 
     ESP_LOGD(TAG, "Setting display unit");
@@ -985,9 +2233,10 @@ void GreeACCNT::on_display_unit_change(const std::string &display_unit)
     this->display_unit_state_ = display_unit;
 }
 
-void GreeACCNT::on_light_change(bool light)
+template<typename Policy>
+void GreeACCNTEngine<Policy>::on_light_change(bool light)
 {
-    if (this->state_ != ACState::Ready)
+    if (this->state_ != ACState::Ready || !this->tx_enabled_)
         return;
 
     ESP_LOGD(TAG, "Setting light");
@@ -996,9 +2245,10 @@ void GreeACCNT::on_light_change(bool light)
     this->light_state_ = light;
 }
 
-void GreeACCNT::on_ionizer_change(bool ionizer)
+template<typename Policy>
+void GreeACCNTEngine<Policy>::on_ionizer_change(bool ionizer)
 {
-    if (this->state_ != ACState::Ready)
+    if (this->state_ != ACState::Ready || !this->tx_enabled_)
         return;
 
     ESP_LOGD(TAG, "Setting ionizer");
@@ -1007,9 +2257,10 @@ void GreeACCNT::on_ionizer_change(bool ionizer)
     this->ionizer_state_ = ionizer;
 }
 
-void GreeACCNT::on_beeper_change(bool beeper)
+template<typename Policy>
+void GreeACCNTEngine<Policy>::on_beeper_change(bool beeper)
 {
-    if (this->state_ != ACState::Ready)
+    if (this->state_ != ACState::Ready || !this->tx_enabled_)
         return;
 
     ESP_LOGD(TAG, "Setting beeper");
@@ -1018,9 +2269,10 @@ void GreeACCNT::on_beeper_change(bool beeper)
     this->beeper_state_ = beeper;
 }
 
-void GreeACCNT::on_sleep_change(bool sleep)
+template<typename Policy>
+void GreeACCNTEngine<Policy>::on_sleep_change(bool sleep)
 {
-    if (this->state_ != ACState::Ready)
+    if (this->state_ != ACState::Ready || !this->tx_enabled_)
         return;
 
     ESP_LOGD(TAG, "Setting sleep");
@@ -1029,9 +2281,10 @@ void GreeACCNT::on_sleep_change(bool sleep)
     this->sleep_state_ = sleep;
 }
 
-void GreeACCNT::on_xfan_change(bool xfan)
+template<typename Policy>
+void GreeACCNTEngine<Policy>::on_xfan_change(bool xfan)
 {
-    if (this->state_ != ACState::Ready)
+    if (this->state_ != ACState::Ready || !this->tx_enabled_)
         return;
 
     ESP_LOGD(TAG, "Setting xfan");
@@ -1040,9 +2293,10 @@ void GreeACCNT::on_xfan_change(bool xfan)
     this->xfan_state_ = xfan;
 }
 
-void GreeACCNT::on_powersave_change(bool powersave)
+template<typename Policy>
+void GreeACCNTEngine<Policy>::on_powersave_change(bool powersave)
 {
-    if (this->state_ != ACState::Ready)
+    if (this->state_ != ACState::Ready || !this->tx_enabled_)
         return;
 
     ESP_LOGD(TAG, "Setting powersave");
@@ -1051,9 +2305,10 @@ void GreeACCNT::on_powersave_change(bool powersave)
     this->powersave_state_ = powersave;
 }
 
-void GreeACCNT::on_turbo_change(bool turbo)
+template<typename Policy>
+void GreeACCNTEngine<Policy>::on_turbo_change(bool turbo)
 {
-    if (this->state_ != ACState::Ready)
+    if (this->state_ != ACState::Ready || !this->tx_enabled_)
         return;
 
     ESP_LOGD(TAG, "Setting turbo");
@@ -1067,9 +2322,10 @@ void GreeACCNT::on_turbo_change(bool turbo)
     }
 }
 
-void GreeACCNT::on_ifeel_change(bool ifeel)
+template<typename Policy>
+void GreeACCNTEngine<Policy>::on_ifeel_change(bool ifeel)
 {
-    if (this->state_ != ACState::Ready)
+    if (this->state_ != ACState::Ready || !this->tx_enabled_)
         return;
 
     ESP_LOGD(TAG, "Setting ifeel");
@@ -1078,9 +2334,10 @@ void GreeACCNT::on_ifeel_change(bool ifeel)
     this->ifeel_state_ = ifeel;
 }
 
-void GreeACCNT::on_quiet_change(const std::string &quiet)
+template<typename Policy>
+void GreeACCNTEngine<Policy>::on_quiet_change(const std::string &quiet)
 {
-    if (this->state_ != ACState::Ready)
+    if (this->state_ != ACState::Ready || !this->tx_enabled_)
         return;
 
     ESP_LOGD(TAG, "Setting quiet mode");
@@ -1094,6 +2351,9 @@ void GreeACCNT::on_quiet_change(const std::string &quiet)
     }
 }
 
+template class GreeACCNTEngine<GreeACCNTProtocol>;
+template class GreeACCNTEngine<SinclairASC18Protocol>;
+
 }  // namespace CNT
 }  // namespace gree_ac
 }  // namespace esphome
@@ -2,6 +2,12 @@
 #include "esphome/components/climate/climate.h"
 #include "esphome/components/climate/climate_mode.h"
 #include "gree_ac.h"
+#include "esphome/core/defines.h"
+#include "esphome/core/preferences.h"
+
+#ifdef USE_TIME
+#include "esphome/components/time/real_time_clock.h"
+#endif
 
 namespace esphome {
 namespace gree_ac {
@@ -18,183 +24,613 @@ enum class ACUpdate {
     UpdateClear, /* update without 0xAF and cleared static flag */
 };
 
+/* outgoing message types, in order of priority (first one that is due gets the bus) */
+enum class TxMessage : uint8_t {
+    Command,   /* SET with user changes (UpdateStart / UpdateClear) */
+    KeepAlive, /* SET with no-change flag, unit answers with report */
+    SyncTime,  /* wall clock taken from time: component */
+    MacReport, /* module MAC address */
+    Count,
+    None = Count,
+};
+
+/* on-device thermostat on current_temperature_sensor */
+enum class LocalControl : uint8_t {
+    None,
+    Hysteresis, /* full drive outside the band, hold inside */
+    PI,
+};
+
+enum class LocalControlOutput : uint8_t {
+    Setpoint, /* unit setpoint moves up to max_offset away from the target */
+    Fan,      /* fan speed follows the drive, MIN to MAX */
+};
+
+typedef struct {
+    LocalControl algorithm;
+    LocalControlOutput output;
+    uint32_t update_interval;
+    uint32_t min_command_interval;
+    float hysteresis;  /* half width of the band [degC] */
+    float max_offset;  /* unit setpoint at full drive [degC] */
+    float kp;          /* drive per degC of error */
+    float ki;          /* drive per degC and second */
+} LocalControlSettings_t;
+
+/* state requested by control() and published before the unit confirmed it */
+typedef struct {
+    bool pending;
+    uint32_t since;
+    climate::ClimateMode mode;
+    float target_temperature;
+    const char *fan_mode;
+    climate::ClimateSwingMode swing_mode;
+} OptimisticRequest_t;
+
+/* link quality estimator - EWMAs of observed behaviour, timeouts are derived from them */
+typedef struct {
+    float error_rate;        /* share of damaged frames */
+    float response_rate;     /* share of SET frames answered by a report */
+    float latency;           /* SET to report [ms] */
+    float latency_dev;
+    float interval;          /* between valid reports [ms] */
+    float interval_dev;
+    uint32_t response_timeout;
+    uint32_t inactive_timeout;
+    uint32_t degraded_since; /* 0 = link is fine */
+    bool error;              /* component error raised by us */
+    uint32_t last_publish;
+} LinkHealth_t;
+
+/* timing of the stock WiFi module observed in sniffer mode */
+typedef struct {
+    uint32_t last_command_end;   /* end of last SET frame sent by stock module */
+    bool awaiting_response;      /* SET seen, report not yet */
+    uint32_t commands;
+    uint32_t responses;
+    uint32_t interval;           /* EWMA of SET to SET [ms] */
+    uint32_t interval_min;
+    uint32_t interval_max;
+    uint32_t latency;            /* EWMA of SET end to report start [ms] */
+    uint32_t latency_min;
+    uint32_t latency_max;
+    uint32_t last_summary;
+} SnifferStats_t;
+
+/* line settings tried by auto-detection */
+typedef struct {
+    uint32_t baud_rate;
+    uart::UARTParityOptions parity;
+} LineSettings_t;
+
+/* sensor fed from one byte of an extended telemetry frame (0x33 / 0x44) */
+typedef struct {
+    sensor::Sensor *sensor;
+    uint8_t command;
+    uint8_t byte;               /* index after the 4 header bytes, as REPORT_* */
+    uint8_t mask;
+    float multiplier;
+    float offset;
+    uint32_t sampling_interval; /* [ms] frames in between are not decoded for this sensor */
+    uint32_t publish_interval;  /* [ms] minimum time between two published states */
+    float delta;                /* smaller changes are not published */
+    uint32_t last_sample;
+    uint32_t last_publish;
+    float last_value;           /* as published, before any sensor filters */
+    bool published;
+} Telemetry_t;
+
+typedef struct {
+    uint32_t period_ms; /* 0 disables the message */
+    uint32_t last_sent; /* low priority messages only, SET frames go by last_packet_sent_ */
+} TxSchedule_t;
+
 namespace protocol {
+    /* time constraints */
+    static const unsigned long TIME_REFRESH_PERIOD_MS   =  300;
+    static const unsigned long TIME_TIMEOUT_INACTIVE_MS = 1000;      /* lower bound of learned inactivity timeout */
+    static const unsigned long TIME_TIMEOUT_INACTIVE_MAX_MS = 10000;
+    static const unsigned long TIME_WAIT_RESPONSE_TIMEOUT_MS = 1000; /* until response latency is learned */
+    static const unsigned long TIME_WAIT_RESPONSE_MIN_MS = 300;
+    static const unsigned long TIME_WAIT_RESPONSE_MAX_MS = 3000;
+    static const float         LINK_EWMA_ALPHA = 0.125f;
+    static const uint8_t       LINK_QUALITY_MIN = 50;               /* [%] below this the link counts as degraded */
+    static const unsigned long TIME_LINK_DEGRADED_MS = 10000;       /* degradation must last this long to raise an error */
+    static const unsigned long TIME_LINK_PUBLISH_MS = 10000;
+    static const unsigned long TIME_STARTUP_LISTEN_MS = 3000; /* listen only after boot, then poll in case unit does not talk first */
+    static const unsigned long TIME_TX_GUARD_MS = 5;          /* idle line required before we start a frame */
+    static const uint8_t       REPORT_CADENCE_WEIGHT = 8;     /* EWMA weight for learned report interval */
+    static const unsigned long TIME_OPTIMISTIC_CONFIRM_MS = 2000;  /* how long unit may take to confirm optimistic state */
+    static const unsigned long TIME_SAVE_COALESCE_MS      = 10000;    /* let bursts of changes settle before saving */
+    static const unsigned long TIME_SAVE_MIN_INTERVAL_MS  = 300000;   /* default minimum time between flash writes */
+    static const uint8_t       SAVED_STATE_VERSION        = 2;
+    static const unsigned long TIME_DETECT_LISTEN_MS      = 1000;     /* listen only on new line settings */
+    static const unsigned long TIME_DETECT_DWELL_MS       = 2500;     /* then poll, until we move to next settings */
+    static const uint8_t       DETECT_TYPE_C_FRAMES       = 3;        /* consecutive valid Type-C frames to skip the settings */
+    static const uint8_t       SNIFFER_EWMA_WEIGHT        = 8;
+    static const unsigned long TIME_SNIFFER_SUMMARY_MS    = 60000;
+    static const unsigned long TIME_SYNC_TIME_PERIOD_MS   = 0;        /* off until the frame layout is confirmed */
+    static const unsigned long TIME_MAC_REPORT_PERIOD_MS  = 3600000;
+}
+
+/* report bytes compared to detect changes made by the unit, resolved against the byte map of each policy */
+#define GREE_AC_REPORT_CHANGE_BYTES \
+    {REPORT_PWR_BYTE, REPORT_TEMP_SET_BYTE, REPORT_FAN_TURBO_BYTE, REPORT_HSWING_BYTE, REPORT_VSWING_BYTE, \
+     REPORT_DISP_MODE_BYTE, REPORT_POWERSAVE_BYTE, REPORT_FAN_QUIET_BYTE, REPORT_FAN_SPD1_BYTE, REPORT_BEEPER_BYTE}
+
+/* byte index of a field whose position no capture has confirmed yet, the field is not sent */
+static constexpr uint8_t FIELD_UNKNOWN = 0xFF;
+
+/*
+ * Protocol policies - byte map, frame constants and checksum of one WiFi module protocol.
+ * GreeACCNTEngine is compiled against one of them, so field access costs nothing at runtime.
+ */
+struct CNTProtocol {
+    static constexpr const char *NAME = "Gree CNT";
+
     /* SYNC */
-    static const uint8_t SYNC                = 0x7E;
+    static constexpr uint8_t SYNC                = 0x7E;
     /* packet types */
-    static const uint8_t CMD_IN_UNIT_REPORT  = 0x31;
-    static const uint8_t CMD_OUT_PARAMS_SET  = 0x01;
-    static const uint8_t CMD_OUT_SYNC_TIME   = 0x03;
-    static const uint8_t CMD_OUT_MAC_REPORT  = 0x04; /* 7e 7e 0d 04 04 00 00 00 AA BB CC DD EE FF 00 -> AA BB CC DD EE FF = MAC address */
-    static const uint8_t CMD_OUT_UNKNOWN_1   = 0x02; /* 7e 7e 10 02 00 00 00 00 00 00 01 00 28 1e 19 23 23 00 b8 */
-    static const uint8_t CMD_IN_UNKNOWN_1    = 0x44; /* 7e 7e 1a 44 01 00 01 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 01 */
-    static const uint8_t CMD_IN_UNKNOWN_2    = 0x33; /* 7e 7e 2f 33 00 00 40 00 09 20 19 0a 00 10 00 14 17 5b 08 08 00 00 00 00 00 00 00 00 01 00 00 0d 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 */
+    static constexpr uint8_t CMD_IN_UNIT_REPORT  = 0x31;
+    static constexpr uint8_t CMD_OUT_PARAMS_SET  = 0x01;
+    static constexpr uint8_t CMD_OUT_SYNC_TIME   = 0x03;
+    static constexpr uint8_t CMD_OUT_MAC_REPORT  = 0x04; /* 7e 7e 0d 04 04 00 00 00 AA BB CC DD EE FF 00 -> AA BB CC DD EE FF = MAC address */
+    static constexpr uint8_t CMD_OUT_UNKNOWN_1   = 0x02; /* 7e 7e 10 02 00 00 00 00 00 00 01 00 28 1e 19 23 23 00 b8 */
+    static constexpr uint8_t CMD_IN_UNKNOWN_1    = 0x44; /* telemetry, layout unknown: 7e 7e 1a 44 01 00 01 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 01 */
+    static constexpr uint8_t CMD_IN_UNKNOWN_2    = 0x33; /* telemetry, layout unknown: 7e 7e 2f 33 00 00 40 00 09 20 19 0a 00 10 00 14 17 5b 08 08 00 00 00 00 00 00 00 00 01 00 00 0d 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 00 */
 
     /* byte indexes are AFTER we remove first 4 bytes from the packet (sync, length, type) as well as a checksum */
     /* unit report packet data fields, for binary values there is no need to define bit offset/position */
-    static const uint8_t REPORT_PWR_BYTE       = 4;
-    static const uint8_t REPORT_PWR_MASK       = 0b10000000;
-
-    static const uint8_t REPORT_MODE_BYTE      = 4;
-    static const uint8_t REPORT_MODE_MASK      = 0b01110000;
-    static const uint8_t REPORT_MODE_POS       = 4;
-    static const uint8_t REPORT_MODE_AUTO          = 0;
-    static const uint8_t REPORT_MODE_COOL          = 1;
-    static const uint8_t REPORT_MODE_DRY           = 2;
-    static const uint8_t REPORT_MODE_FAN           = 3;
-    static const uint8_t REPORT_MODE_HEAT          = 4;
-
-    static const uint8_t REPORT_FAN_SPD1_BYTE  = 18;
-    static const uint8_t REPORT_FAN_SPD1_MASK  = 0b00001111;
-    static const uint8_t REPORT_FAN_SPD1_POS   = 0;
-    static const uint8_t REPORT_FAN_SPD2_BYTE  = 4;
-    static const uint8_t REPORT_FAN_SPD2_MASK  = 0b00000111;
-    static const uint8_t REPORT_FAN_SPD2_POS   = 0;
-    static const uint8_t REPORT_FAN_QUIET_BYTE = 16;
-    static const uint8_t REPORT_FAN_QUIET_MASK = 0b00001000;
-    static const uint8_t REPORT_FAN_QUIET_AUTO_MASK = 0b00000100;
-    static const uint8_t REPORT_FAN_TURBO_BYTE = 6;
-    static const uint8_t REPORT_FAN_TURBO_MASK = 0b00000001;
-
-    static const uint8_t REPORT_FAN_MODE_MASK = 0b00000111;
-
-    static const uint8_t REPORT_TEMP_SET_BYTE  = 5;
-    static const uint8_t REPORT_TEMP_SET_MASK  = 0b11110000;
-    static const uint8_t REPORT_TEMP_SET_POS   = 4;
-    static const uint8_t REPORT_TEMP_SET_OFF   = 16; /* temperature offset from value in packet */
-
-    static const uint8_t REPORT_TEMP_ACT_BYTE  = 42;
-    static const uint8_t REPORT_TEMP_ACT_OFF   = 40; /* temperature offset from value in packet */
-
-    static const uint8_t REPORT_HSWING_BYTE    = 8;
-    static const uint8_t REPORT_HSWING_MASK    = 0b00000111;
-    static const uint8_t REPORT_HSWING_POS     = 0;
-    static const uint8_t REPORT_HSWING_OFF         = 0;
-    static const uint8_t REPORT_HSWING_FULL        = 1;
-    static const uint8_t REPORT_HSWING_CLEFT       = 2;
-    static const uint8_t REPORT_HSWING_CMIDL       = 3;
-    static const uint8_t REPORT_HSWING_CMID        = 4;
-    static const uint8_t REPORT_HSWING_CMIDR       = 5;
-    static const uint8_t REPORT_HSWING_CRIGHT      = 6;
-
-    static const uint8_t REPORT_VSWING_BYTE    = 8;
-    static const uint8_t REPORT_VSWING_MASK    = 0b11110000;
-    static const uint8_t REPORT_VSWING_POS     = 4;
-    static const uint8_t REPORT_VSWING_OFF         = 0;
-    static const uint8_t REPORT_VSWING_FULL        = 1;
-    static const uint8_t REPORT_VSWING_CUP         = 2;
-    static const uint8_t REPORT_VSWING_CMIDU       = 3;
-    static const uint8_t REPORT_VSWING_CMID        = 4;
-    static const uint8_t REPORT_VSWING_CMIDD       = 5;
-    static const uint8_t REPORT_VSWING_CDOWN       = 6;
-    static const uint8_t REPORT_VSWING_DOWN        = 7;
-    static const uint8_t REPORT_VSWING_MIDD        = 8;
-    static const uint8_t REPORT_VSWING_MID         = 9;
-    static const uint8_t REPORT_VSWING_MIDU        = 10;
-    static const uint8_t REPORT_VSWING_UP          = 11;
-
-    static const uint8_t REPORT_DISP_ON_BYTE   = 6;
-    static const uint8_t REPORT_DISP_ON_MASK   = 0b00000010;
-    static const uint8_t REPORT_DISP_MODE_BYTE = 9;
-    static const uint8_t REPORT_DISP_MODE_MASK = 0b00110000;
-    static const uint8_t REPORT_DISP_MODE_POS  = 4;
-    static const uint8_t REPORT_DISP_MODE_AUTO     = 0;
-    static const uint8_t REPORT_DISP_MODE_SET      = 1;
-    static const uint8_t REPORT_DISP_MODE_ACT      = 2;
-    static const uint8_t REPORT_DISP_MODE_OUT      = 3;
-
-    static const uint8_t REPORT_DISP_F_BYTE    = 7;
-    static const uint8_t REPORT_DISP_F_MASK    = 0b10000000;
-
-    static const uint8_t REPORT_IONIZER1_BYTE    = 6;
-    static const uint8_t REPORT_IONIZER1_MASK    = 0b00000100;
-    static const uint8_t REPORT_IONIZER2_BYTE    = 0;
-    static const uint8_t REPORT_IONIZER2_MASK    = 0b00000100;
-
-    static const uint8_t REPORT_SLEEP_BYTE       = 4;
-    static const uint8_t REPORT_SLEEP_MASK       = 0b00001000;
-
-    static const uint8_t REPORT_XFAN_BYTE        = 6;
-    static const uint8_t REPORT_XFAN_MASK        = 0b00001000;
-
-    static const uint8_t REPORT_POWERSAVE_BYTE   = 11;
-    static const uint8_t REPORT_POWERSAVE_MASK   = 0b01000000;
-
-    static const uint8_t REPORT_IFEEL_BYTE       = 9;
-    static const uint8_t REPORT_IFEEL_MASK       = 0b01000000;
-
-    static const uint8_t REPORT_BEEPER_BYTE    = 40;
-    static const uint8_t REPORT_BEEPER_MASK    = 0b00000001;
+    static constexpr uint8_t REPORT_PWR_BYTE       = 4;
+    static constexpr uint8_t REPORT_PWR_MASK       = 0b10000000;
+
+    static constexpr uint8_t REPORT_MODE_BYTE      = 4;
+    static constexpr uint8_t REPORT_MODE_MASK      = 0b01110000;
+    static constexpr uint8_t REPORT_MODE_POS       = 4;
+    static constexpr uint8_t REPORT_MODE_AUTO          = 0;
+    static constexpr uint8_t REPORT_MODE_COOL          = 1;
+    static constexpr uint8_t REPORT_MODE_DRY           = 2;
+    static constexpr uint8_t REPORT_MODE_FAN           = 3;
+    static constexpr uint8_t REPORT_MODE_HEAT          = 4;
+
+    static constexpr uint8_t REPORT_FAN_SPD1_BYTE  = 18;
+    static constexpr uint8_t REPORT_FAN_SPD1_MASK  = 0b00001111;
+    static constexpr uint8_t REPORT_FAN_SPD1_POS   = 0;
+    static constexpr uint8_t REPORT_FAN_SPD2_BYTE  = 4;
+    static constexpr uint8_t REPORT_FAN_SPD2_MASK  = 0b00000111;
+    static constexpr uint8_t REPORT_FAN_SPD2_POS   = 0;
+    static constexpr uint8_t REPORT_FAN_QUIET_BYTE = 16;
+    static constexpr uint8_t REPORT_FAN_QUIET_MASK = 0b00001000;
+    static constexpr uint8_t REPORT_FAN_QUIET_AUTO_MASK = 0b00000100;
+    static constexpr uint8_t REPORT_FAN_TURBO_BYTE = 6;
+    static constexpr uint8_t REPORT_FAN_TURBO_MASK = 0b00000001;
+
+    static constexpr uint8_t REPORT_FAN_MODE_MASK = 0b00000111;
+
+    static constexpr uint8_t REPORT_TEMP_SET_BYTE  = 5;
+    static constexpr uint8_t REPORT_TEMP_SET_MASK  = 0b11110000;
+    static constexpr uint8_t REPORT_TEMP_SET_POS   = 4;
+    static constexpr uint8_t REPORT_TEMP_SET_OFF   = 16; /* temperature offset from value in packet */
+
+    static constexpr uint8_t REPORT_TEMP_ACT_BYTE  = 42;
+    static constexpr uint8_t REPORT_TEMP_ACT_OFF   = 40; /* temperature offset from value in packet */
+
+    static constexpr uint8_t REPORT_HSWING_BYTE    = 8;
+    static constexpr uint8_t REPORT_HSWING_MASK    = 0b00000111;
+    static constexpr uint8_t REPORT_HSWING_POS     = 0;
+    static constexpr uint8_t REPORT_HSWING_OFF         = 0;
+    static constexpr uint8_t REPORT_HSWING_FULL        = 1;
+    static constexpr uint8_t REPORT_HSWING_CLEFT       = 2;
+    static constexpr uint8_t REPORT_HSWING_CMIDL       = 3;
+    static constexpr uint8_t REPORT_HSWING_CMID        = 4;
+    static constexpr uint8_t REPORT_HSWING_CMIDR       = 5;
+    static constexpr uint8_t REPORT_HSWING_CRIGHT      = 6;
+
+    static constexpr uint8_t REPORT_VSWING_BYTE    = 8;
+    static constexpr uint8_t REPORT_VSWING_MASK    = 0b11110000;
+    static constexpr uint8_t REPORT_VSWING_POS     = 4;
+    static constexpr uint8_t REPORT_VSWING_OFF         = 0;
+    static constexpr uint8_t REPORT_VSWING_FULL        = 1;
+    static constexpr uint8_t REPORT_VSWING_CUP         = 2;
+    static constexpr uint8_t REPORT_VSWING_CMIDU       = 3;
+    static constexpr uint8_t REPORT_VSWING_CMID        = 4;
+    static constexpr uint8_t REPORT_VSWING_CMIDD       = 5;
+    static constexpr uint8_t REPORT_VSWING_CDOWN       = 6;
+    static constexpr uint8_t REPORT_VSWING_DOWN        = 7;
+    static constexpr uint8_t REPORT_VSWING_MIDD        = 8;
+    static constexpr uint8_t REPORT_VSWING_MID         = 9;
+    static constexpr uint8_t REPORT_VSWING_MIDU        = 10;
+    static constexpr uint8_t REPORT_VSWING_UP          = 11;
+
+    static constexpr uint8_t REPORT_DISP_ON_BYTE   = 6;
+    static constexpr uint8_t REPORT_DISP_ON_MASK   = 0b00000010;
+    static constexpr uint8_t REPORT_DISP_MODE_BYTE = 9;
+    static constexpr uint8_t REPORT_DISP_MODE_MASK = 0b00110000;
+    static constexpr uint8_t REPORT_DISP_MODE_POS  = 4;
+    static constexpr uint8_t REPORT_DISP_MODE_AUTO     = 0;
+    static constexpr uint8_t REPORT_DISP_MODE_SET      = 1;
+    static constexpr uint8_t REPORT_DISP_MODE_ACT      = 2;
+    static constexpr uint8_t REPORT_DISP_MODE_OUT      = 3;
+
+    static constexpr uint8_t REPORT_DISP_F_BYTE    = 7;
+    static constexpr uint8_t REPORT_DISP_F_MASK    = 0b10000000;
+
+    static constexpr uint8_t REPORT_IONIZER1_BYTE    = 6;
+    static constexpr uint8_t REPORT_IONIZER1_MASK    = 0b00000100;
+    static constexpr uint8_t REPORT_IONIZER2_BYTE    = 0;
+    static constexpr uint8_t REPORT_IONIZER2_MASK    = 0b00000100;
+
+    static constexpr uint8_t REPORT_SLEEP_BYTE       = 4;
+    static constexpr uint8_t REPORT_SLEEP_MASK       = 0b00001000;
+
+    static constexpr uint8_t REPORT_XFAN_BYTE        = 6;
+    static constexpr uint8_t REPORT_XFAN_MASK        = 0b00001000;
+
+    static constexpr uint8_t REPORT_POWERSAVE_BYTE   = 11;
+    static constexpr uint8_t REPORT_POWERSAVE_MASK   = 0b01000000;
+
+    static constexpr uint8_t REPORT_IFEEL_BYTE       = 9;
+    static constexpr uint8_t REPORT_IFEEL_MASK       = 0b01000000;
+
+    static constexpr uint8_t REPORT_BEEPER_BYTE    = 40;
+    static constexpr uint8_t REPORT_BEEPER_MASK    = 0b00000001;
 
     /* SET packet shares all the byte definition with REPORT */
-    static const uint8_t SET_PACKET_LEN        = 45;
+    static constexpr uint8_t SET_PACKET_LEN        = 45;
     
-    static const uint8_t SET_CONST_02_BYTE     = 39;
-    static const uint8_t SET_CONST_02_VAL      = 0x02;
+    static constexpr uint8_t SET_CONST_02_BYTE     = 39;
+    static constexpr uint8_t SET_CONST_02_VAL      = 0x02;
+
+    static constexpr uint8_t SET_AF_BYTE           = 3;
+    static constexpr uint8_t SET_AF_VAL            = 0xAF;
+
+    static constexpr uint8_t SET_NOCHANGE_BYTE     = 11;
+    static constexpr uint8_t SET_NOCHANGE_MASK     = 0b00001000;
+
+    static constexpr uint8_t SET_CONST_BIT_BYTE    = 7;
+    static constexpr uint8_t SET_CONST_BIT_MASK    = 0b00000010;
+
+    /* iFeel room temperature - position unknown, field_map has to provide it */
+    static constexpr uint8_t SET_IFEEL_TEMP_BYTE   = FIELD_UNKNOWN;
+    static constexpr uint8_t SET_IFEEL_TEMP_OFF    = REPORT_TEMP_ACT_OFF;
+
+    /* SYNC TIME packet - layout not confirmed by a capture yet: YY MM DD hh mm ss WD */
+    static constexpr uint8_t SYNC_TIME_PACKET_LEN  = 7;
+    static constexpr uint8_t SYNC_TIME_YEAR_BYTE   = 0; /* years since 2000 */
+    static constexpr uint8_t SYNC_TIME_MONTH_BYTE  = 1;
+    static constexpr uint8_t SYNC_TIME_DAY_BYTE    = 2;
+    static constexpr uint8_t SYNC_TIME_HOUR_BYTE   = 3;
+    static constexpr uint8_t SYNC_TIME_MINUTE_BYTE = 4;
+    static constexpr uint8_t SYNC_TIME_SECOND_BYTE = 5;
+    static constexpr uint8_t SYNC_TIME_WDAY_BYTE   = 6; /* 1 = Sunday, as in ESPTime */
+
+    /* MAC REPORT packet: 04 00 00 00 AA BB CC DD EE FF 00 */
+    static constexpr uint8_t MAC_REPORT_PACKET_LEN = 11;
+    static constexpr uint8_t MAC_REPORT_CONST_BYTE = 0;
+    static constexpr uint8_t MAC_REPORT_CONST_VAL  = 0x04;
+    static constexpr uint8_t MAC_REPORT_MAC_BYTE   = 4;
+
+    /* IR remote, panel */
+    static constexpr uint8_t REPORT_CHANGE_BYTES[] = GREE_AC_REPORT_CHANGE_BYTES;
+
+    /* sum of all bytes except sync and checksum itself, modulo 0x100 */
+    static uint8_t checksum(const uint8_t *frame, uint8_t len)
+    {
+        uint8_t sum = 0;
+        for (uint8_t i = 2; i < len - 1; i++)
+        {
+            sum += frame[i];
+        }
+        return sum;
+    }
+};
+
+/* Sinclair ASC-18 WiFi module - same frames and byte map as CNT, checked against all captures in documents/protocol.txt */
+struct ASC18Protocol : CNTProtocol {
+    static constexpr const char *NAME = "Sinclair ASC-18";
+};
 
-    static const uint8_t SET_AF_BYTE           = 3;
-    static const uint8_t SET_AF_VAL            = 0xAF;
+#ifdef USE_GREE_AC_FIELD_MAP
+/*
+ * Byte map overrides from field_map: in YAML. climate.py emits GREE_AC_FIELD_MAP as a list of
+ * {name, value} pairs and reads GREE_AC_FIELDS below to validate the names, so both sides share
+ * one list. Lookups are constexpr - the engine still sees plain constants.
+ */
+#define GREE_AC_FIELDS(X) \
+    X(REPORT_PWR_BYTE) X(REPORT_PWR_MASK) \
+    X(REPORT_MODE_BYTE) X(REPORT_MODE_MASK) X(REPORT_MODE_POS) X(REPORT_MODE_AUTO) \
+    X(REPORT_MODE_COOL) X(REPORT_MODE_DRY) X(REPORT_MODE_FAN) X(REPORT_MODE_HEAT) \
+    X(REPORT_FAN_SPD1_BYTE) X(REPORT_FAN_SPD1_MASK) X(REPORT_FAN_SPD1_POS) X(REPORT_FAN_SPD2_BYTE) \
+    X(REPORT_FAN_SPD2_MASK) X(REPORT_FAN_SPD2_POS) X(REPORT_FAN_QUIET_BYTE) X(REPORT_FAN_QUIET_MASK) \
+    X(REPORT_FAN_QUIET_AUTO_MASK) X(REPORT_FAN_TURBO_BYTE) X(REPORT_FAN_TURBO_MASK) X(REPORT_FAN_MODE_MASK) \
+    X(REPORT_TEMP_SET_BYTE) X(REPORT_TEMP_SET_MASK) X(REPORT_TEMP_SET_POS) X(REPORT_TEMP_SET_OFF) \
+    X(REPORT_TEMP_ACT_BYTE) X(REPORT_TEMP_ACT_OFF) \
+    X(REPORT_HSWING_BYTE) X(REPORT_HSWING_MASK) X(REPORT_HSWING_POS) X(REPORT_HSWING_OFF) \
+    X(REPORT_HSWING_FULL) X(REPORT_HSWING_CLEFT) X(REPORT_HSWING_CMIDL) X(REPORT_HSWING_CMID) \
+    X(REPORT_HSWING_CMIDR) X(REPORT_HSWING_CRIGHT) \
+    X(REPORT_VSWING_BYTE) X(REPORT_VSWING_MASK) X(REPORT_VSWING_POS) X(REPORT_VSWING_OFF) \
+    X(REPORT_VSWING_FULL) X(REPORT_VSWING_CUP) X(REPORT_VSWING_CMIDU) X(REPORT_VSWING_CMID) \
+    X(REPORT_VSWING_CMIDD) X(REPORT_VSWING_CDOWN) X(REPORT_VSWING_DOWN) X(REPORT_VSWING_MIDD) \
+    X(REPORT_VSWING_MID) X(REPORT_VSWING_MIDU) X(REPORT_VSWING_UP) \
+    X(REPORT_DISP_ON_BYTE) X(REPORT_DISP_ON_MASK) X(REPORT_DISP_MODE_BYTE) X(REPORT_DISP_MODE_MASK) \
+    X(REPORT_DISP_MODE_POS) X(REPORT_DISP_MODE_AUTO) X(REPORT_DISP_MODE_SET) X(REPORT_DISP_MODE_ACT) \
+    X(REPORT_DISP_MODE_OUT) X(REPORT_DISP_F_BYTE) X(REPORT_DISP_F_MASK) \
+    X(REPORT_IONIZER1_BYTE) X(REPORT_IONIZER1_MASK) \
+    X(REPORT_IONIZER2_BYTE) X(REPORT_IONIZER2_MASK) \
+    X(REPORT_SLEEP_BYTE) X(REPORT_SLEEP_MASK) \
+    X(REPORT_XFAN_BYTE) X(REPORT_XFAN_MASK) \
+    X(REPORT_POWERSAVE_BYTE) X(REPORT_POWERSAVE_MASK) \
+    X(REPORT_IFEEL_BYTE) X(REPORT_IFEEL_MASK) \
+    X(REPORT_BEEPER_BYTE) X(REPORT_BEEPER_MASK) \
+    X(SET_CONST_02_BYTE) X(SET_CONST_02_VAL) \
+    X(SET_AF_BYTE) X(SET_AF_VAL) \
+    X(SET_NOCHANGE_BYTE) X(SET_NOCHANGE_MASK) \
+    X(SET_CONST_BIT_BYTE) X(SET_CONST_BIT_MASK) \
+    X(SET_IFEEL_TEMP_BYTE) X(SET_IFEEL_TEMP_OFF)
+
+typedef struct {
+    const char *name;
+    uint8_t value;
+} FieldOverride_t;
+
+constexpr bool field_name_equal(const char *a, const char *b)
+{
+    while (*a != '\0' && *a == *b)
+    {
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
 
-    static const uint8_t SET_NOCHANGE_BYTE     = 11;
-    static const uint8_t SET_NOCHANGE_MASK     = 0b00001000;
+template<size_t N>
+constexpr uint8_t field_value(const FieldOverride_t (&map)[N], const char *name, uint8_t fallback)
+{
+    for (size_t i = 0; i < N; i++)
+    {
+        if (field_name_equal(map[i].name, name))
+        {
+            return map[i].value;
+        }
+    }
+    return fallback;
+}
 
-    static const uint8_t SET_CONST_BIT_BYTE    = 7;
-    static const uint8_t SET_CONST_BIT_MASK    = 0b00000010;
+constexpr bool field_is_byte(const char *name)
+{
+    const char *end = name;
+    while (*end != '\0')
+    {
+        end++;
+    }
+    return end - name >= 5 && field_name_equal(end - 5, "_BYTE");
+}
 
-    /* time constraints */
-    static const unsigned long TIME_REFRESH_PERIOD_MS   =  300;
-    static const unsigned long TIME_TIMEOUT_INACTIVE_MS = 1000;
-    static const unsigned long TIME_WAIT_RESPONSE_TIMEOUT_MS = 1000;
+template<size_t N>
+constexpr bool field_bytes_within(const FieldOverride_t (&map)[N], uint8_t len)
+{
+    for (size_t i = 0; i < N; i++)
+    {
+        if (field_is_byte(map[i].name) && map[i].value >= len)
+        {
+            return false;
+        }
+    }
+    return true;
 }
 
-class GreeACCNT : public GreeAC {
+template<typename Base>
+struct FieldMapProtocol : Base {
+    static constexpr FieldOverride_t FIELD_MAP[] = GREE_AC_FIELD_MAP;
+
+#define GREE_AC_MAP_FIELD(name) static constexpr uint8_t name = field_value(FIELD_MAP, #name, Base::name);
+    GREE_AC_FIELDS(GREE_AC_MAP_FIELD)
+#undef GREE_AC_MAP_FIELD
+
+    static_assert(field_bytes_within(FIELD_MAP, Base::SET_PACKET_LEN), "field_map: byte index outside of the SET frame");
+
+    /* follow the remapped bytes */
+    static constexpr uint8_t REPORT_CHANGE_BYTES[] = GREE_AC_REPORT_CHANGE_BYTES;
+};
+#endif
+
+/* last decoded report, kept in flash to restore state after reboot */
+template<typename Policy>
+struct SavedState_t {
+    uint8_t version;
+    uint32_t write_count;
+    uint8_t report[Policy::SET_PACKET_LEN];
+    float target_temperature;  /* room target while local control owns the unit setpoint, NAN otherwise */
+};
+
+template<typename Policy>
+class GreeACCNTEngine : public GreeACVariant<GreeACCNTEngine<Policy>> {
     public:
         void control(const climate::ClimateCall &call) override;
 
-        void on_horizontal_swing_change(const std::string &swing) override;
-        void on_vertical_swing_change(const std::string &swing) override;
+        void on_horizontal_swing_change(const std::string &swing);
+        void on_vertical_swing_change(const std::string &swing);
 
-        void on_display_change(const std::string &display) override;
-        void on_display_unit_change(const std::string &display_unit) override;
+        void on_display_change(const std::string &display);
+        void on_display_unit_change(const std::string &display_unit);
 
-        void on_light_change(bool light) override;
-        void on_ionizer_change(bool ionizer) override;
-        void on_beeper_change(bool beeper) override;
-        void on_sleep_change(bool sleep) override;
-        void on_xfan_change(bool xfan) override;
-        void on_powersave_change(bool powersave) override;
-        void on_turbo_change(bool turbo) override;
-        void on_ifeel_change(bool ifeel) override;
-        void on_quiet_change(const std::string &quiet) override;
+        void on_light_change(bool light);
+        void on_ionizer_change(bool ionizer);
+        void on_beeper_change(bool beeper);
+        void on_sleep_change(bool sleep);
+        void on_xfan_change(bool xfan);
+        void on_powersave_change(bool powersave);
+        void on_turbo_change(bool turbo);
+        void on_ifeel_change(bool ifeel);
+        void on_quiet_change(const std::string &quiet);
 
         void setup() override;
         void loop() override;
 
+#ifdef USE_TIME
+        void set_time(time::RealTimeClock *time) { this->time_ = time; }
+#endif
+        void set_sync_time_interval(uint32_t interval) { this->tx_schedule_[(uint8_t)TxMessage::SyncTime].period_ms = interval; }
+        void set_mac_report_interval(uint32_t interval) { this->tx_schedule_[(uint8_t)TxMessage::MacReport].period_ms = interval; }
+        void set_optimistic(bool optimistic) { this->optimistic_ = optimistic; }
+        void set_restore_state(bool restore_state) { this->restore_saved_state_enabled_ = restore_state; }
+        void set_auto_detect(bool auto_detect) { this->auto_detect_ = auto_detect; }
+        void set_link_quality_sensor(sensor::Sensor *link_quality_sensor) { this->link_quality_sensor_ = link_quality_sensor; }
+        void set_sniffer(bool sniffer) { this->sniffer_ = sniffer; }
+        void set_stock_command_interval_sensor(sensor::Sensor *sensor) { this->stock_command_interval_sensor_ = sensor; }
+        void set_stock_response_latency_sensor(sensor::Sensor *sensor) { this->stock_response_latency_sensor_ = sensor; }
+        void set_state_save_interval(uint32_t interval) { this->state_save_interval_ = interval; }
+        void set_flash_writes_sensor(sensor::Sensor *flash_writes_sensor) { this->flash_writes_sensor_ = flash_writes_sensor; }
+        void set_local_control(LocalControl algorithm, LocalControlOutput output, uint32_t update_interval,
+                               uint32_t min_command_interval, float hysteresis, float max_offset, float kp, float ki)
+        {
+            this->local_control_ = {algorithm, output, update_interval, min_command_interval, hysteresis, max_offset, kp, ki};
+        }
+        void set_ifeel_forwarding(uint32_t interval, float deadband)
+        {
+            this->ifeel_forwarding_ = true;
+            this->ifeel_interval_ = interval;
+            this->ifeel_deadband_ = deadband;
+        }
+        void add_telemetry(sensor::Sensor *sensor, uint8_t command, uint8_t byte, uint8_t mask, float multiplier, float offset,
+                           uint32_t sampling_interval, uint32_t publish_interval, float delta)
+        {
+            this->telemetry_.push_back({sensor, command, byte, mask, multiplier, offset,
+                                        sampling_interval, publish_interval, delta, 0, 0, NAN, false});
+        }
+
+        void dump_config() override;
+
     protected:
         ACState state_ = ACState::Initializing; /* Stores if the AC is responsive or not */
         ACUpdate update_ = ACUpdate::NoUpdate;  /* Stores if we need tu send update to AC or no */
+        bool synced_ = false;                   /* first report was decoded, our state is valid */
 
-        climate::ClimateMode mode_internal_;
-        bool power_internal_;
+        climate::ClimateMode mode_internal_ = climate::CLIMATE_MODE_AUTO;
+        bool power_internal_ = false;
 
         std::string display_mode_internal_;
-        bool display_power_internal_;
-
-        bool processUnitReport();
+        bool display_power_internal_ = false;
+
+        bool processUnitReport(bool hold_request = false);
+
+        bool optimistic_ = false;                     /* publish requested state before unit confirms it */
+        OptimisticRequest_t optimistic_request_ = {}; /* what we published and wait for the unit to confirm */
+        bool report_confirms_request();
+
+        void apply_preset(const climate::ClimateCall &call);
+
+        bool restore_saved_state_enabled_ = false;    /* keep last report in flash and restore it at boot */
+        uint32_t state_save_interval_ = protocol::TIME_SAVE_MIN_INTERVAL_MS;
+        sensor::Sensor *flash_writes_sensor_ = nullptr; /* Number of state writes to flash (lifetime) */
+        ESPPreferenceObject state_pref_;
+        SavedState_t<Policy> saved_state_ = {};
+        bool save_pending_ = false;
+        uint32_t save_requested_ = 0;
+        uint32_t last_save_ = 0;
+        uint32_t saves_since_boot_ = 0;
+
+        LinkHealth_t link_ = {0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+                              protocol::TIME_WAIT_RESPONSE_TIMEOUT_MS, protocol::TIME_TIMEOUT_INACTIVE_MS, 0, false, 0};
+        sensor::Sensor *link_quality_sensor_ = nullptr; /* Link quality percentage */
+
+        void link_frame(bool valid);
+        void link_response(bool received);
+        void link_report();
+        void update_link_health();
+        float link_quality();
+
+        bool sniffer_ = false;             /* listen only, next to the stock WiFi module */
+        SnifferStats_t sniffer_stats_ = {};
+        sensor::Sensor *stock_command_interval_sensor_ = nullptr; /* SET period of stock module */
+        sensor::Sensor *stock_response_latency_sensor_ = nullptr; /* SET end to report start */
+
+        bool sniff_packet();
+        void sniffer_summary();
+
+        std::vector<Telemetry_t> telemetry_; /* empty = telemetry frames are dropped unchecked */
+
+        bool is_telemetry_packet();
+        void handle_telemetry_packet();
+
+        LocalControlSettings_t local_control_ = {LocalControl::None};
+        float control_drive_ = 0;             /* -1 (back off) .. 1 (full cooling / heating) */
+        float control_integral_ = 0;
+        uint32_t control_last_step_ = 0;
+        uint32_t control_last_command_ = 0;
+        float unit_setpoint_ = NAN;           /* setpoint sent instead of target_temperature, NAN = none */
+        float unit_setpoint_prev_ = NAN;      /* the one before, the unit may still report it */
+        bool control_adopt_setpoint_ = false; /* restored room target - the next reported setpoint is ours */
+        const char *control_user_fan_ = nullptr; /* fan mode to restore once local control lets go of the fan */
+        bool control_fan_owned_ = false;
+        bool control_fan_suspended_ = false;  /* the user picked a fan mode, kept until the next target or mode */
+        void update_local_control();
+        void release_local_control();
+        float unit_target_temperature() const { return std::isnan(this->unit_setpoint_) ? this->target_temperature : this->unit_setpoint_; }
+
+        bool ifeel_forwarding_ = false;          /* send current_temperature_sensor in the iFeel field */
+        uint32_t ifeel_interval_ = 0;            /* minimum time between changes of the forwarded value */
+        float ifeel_deadband_ = 0;
+        float ifeel_temperature_ = NAN;          /* value currently forwarded */
+        uint32_t ifeel_updated_ = 0;
+        bool update_ifeel_temperature();
+
+        bool auto_detect_ = false;  /* try known line settings until unit reports are decoded */
+        bool tx_enabled_ = true;    /* false if the unit talks a protocol we must not answer */
+        uint8_t detect_index_ = 0;
+        uint32_t detect_started_ = 0;
+
+        void start_line_detection();
+        void detect_line();
+        void apply_line_settings(uint8_t index);
+
+        void restore_saved_state();
+        void queue_state_save();
+        void flush_state_save();
 
         void send_packet();
+        void send_params_packet();
+        void send_sync_time_packet();
+        void send_mac_report_packet();
+        void write_frame(uint8_t command, const uint8_t *payload, uint8_t len);
+
+        TxMessage next_tx_message();
+        bool tx_due(TxMessage message);
+        bool tx_slot_free(uint8_t len);
+        void learn_report_cadence(bool solicited);
+
+        TxSchedule_t tx_schedule_[(uint8_t)TxMessage::Count] = {
+            {protocol::TIME_REFRESH_PERIOD_MS, 0},    /* Command */
+            {protocol::TIME_REFRESH_PERIOD_MS, 0},    /* KeepAlive */
+            {protocol::TIME_SYNC_TIME_PERIOD_MS, 0},  /* SyncTime */
+            {protocol::TIME_MAC_REPORT_PERIOD_MS, 0}, /* MacReport */
+        };
+        uint32_t last_aux_sent_ = 0;  /* time at which the last frame without a report in response was sent */
+        uint32_t aux_frame_time_ = 0; /* air time of that frame [ms] */
+
+        uint32_t last_unsolicited_report_ = 0;  /* end time of last report the unit sent on its own */
+        uint32_t report_interval_ = 0;          /* learned interval of unsolicited reports [ms], 0 = unknown */
+        uint32_t report_air_time_ = 0;          /* air time of a report [ms] */
+
+#ifdef USE_TIME
+        time::RealTimeClock *time_ = nullptr;
+#endif
 
         bool reqmodechange = false;
         unsigned char lastpacket[60];
+        bool lastpacket_valid_ = false;  /* nothing sent yet (sniffer mode never sends) */
 
         bool verify_packet();
         void handle_packet();
 
         climate::ClimateMode determine_mode();
-        const char* determine_fan_mode();
+        bool decode_power();
+        climate::ClimateMode decode_mode_internal();
+        const char* determine_fan_mode(bool warn = true);
 
-        const char* determine_vertical_swing();
-        const char* determine_horizontal_swing();
+        const char* determine_vertical_swing(bool warn = true);
+        const char* determine_horizontal_swing(bool warn = true);
+        climate::ClimateSwingMode determine_swing_mode(const char *vertical_swing, const char *horizontal_swing);
 
         const char* determine_display();
         const char* determine_display_unit();
@@ -210,6 +646,19 @@ class GreeACCNT : public GreeAC {
         const char* determine_quiet();
 };
 
+#ifdef USE_GREE_AC_FIELD_MAP
+typedef FieldMapProtocol<CNTProtocol> GreeACCNTProtocol;
+typedef FieldMapProtocol<ASC18Protocol> SinclairASC18Protocol;
+#else
+typedef CNTProtocol GreeACCNTProtocol;
+typedef ASC18Protocol SinclairASC18Protocol;
+#endif
+
+extern template class GreeACCNTEngine<GreeACCNTProtocol>;
+extern template class GreeACCNTEngine<SinclairASC18Protocol>;
+
+using GreeACCNT = GreeACCNTEngine<GreeACCNTProtocol>;
+
 }  // namespace CNT
 }  // namespace gree_ac
 }  // namespace esphome
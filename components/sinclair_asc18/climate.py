@@ -1,29 +1,33 @@
-import esphome.codegen as cg
-import esphome.config_validation as cv
-from esphome.components import climate, uart
-from esphome.const import CONF_ID, CONF_UART_ID
-
-AUTO_LOAD = ["uart"]
-
-sinclair_ns = cg.esphome_ns.namespace("sinclair_asc18")
-SinclairASC18Climate = sinclair_ns.class_(
-    "SinclairASC18Climate",
-    climate.Climate,
-    uart.UARTDevice,
-    cg.Component,
-)
-
-CONFIG_SCHEMA = climate.CLIMATE_SCHEMA.extend(
-    {
-        cv.GenerateID(): cv.declare_id(SinclairASC18Climate),
-        cv.GenerateID(CONF_UART_ID): cv.use_id(uart.UARTComponent),
-    }
-)
-
-async def to_code(config):
-    var = cg.new_Pvariable(config[CONF_ID])
-    await cg.register_component(var, config)
-    await climate.register_climate(var, config)
-
-    uart_component = await cg.get_variable(config[CONF_UART_ID])
-    cg.add(var.set_uart_parent(uart_component))
+import esphome.codegen as cg
+import esphome.config_validation as cv
+from esphome.components.gree_ac.climate import (
+    GreeAC,
+    SCHEMA,
+    final_validate_field_map,
+    validate_external_sensor,
+    to_code as gree_ac_to_code,
+)
+
+AUTO_LOAD = ["gree_ac", "switch", "sensor", "select", "button"]
+DEPENDENCIES = ["uart"]
+
+sinclair_ns = cg.esphome_ns.namespace("sinclair_asc18")
+SinclairASC18Climate = sinclair_ns.class_(
+    "SinclairASC18Climate",
+    GreeAC,
+    cg.Component,
+)
+
+CONFIG_SCHEMA = cv.All(
+    SCHEMA.extend(
+        {
+            cv.GenerateID(): cv.declare_id(SinclairASC18Climate),
+        }
+    ),
+    validate_external_sensor,
+)
+
+FINAL_VALIDATE_SCHEMA = final_validate_field_map
+
+async def to_code(config):
+    await gree_ac_to_code(config)
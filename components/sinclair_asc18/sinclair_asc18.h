@@ -1,31 +1,13 @@
-#pragma once
-
-#include "esphome/components/climate/climate.h"
-#include "esphome/components/uart/uart.h"
-#include "esphome/core/component.h"
-
-namespace esphome {
-namespace sinclair_asc18 {
-
-class SinclairASC18Climate : public climate::Climate,
-                             public uart::UARTDevice,
-                             public Component {
- public:
-  void setup() override;
-  void loop() override;
-  climate::ClimateTraits traits() override;
-  void control(const climate::ClimateCall &call) override;
-
-  void set_uart_parent(uart::UARTComponent *parent) { this->set_parent(parent); }
-
- protected:
-  void send_state_to_ac_();
-  void handle_incoming_();
-
-  bool power_{true};
-  climate::ClimateMode mode_{climate::CLIMATE_MODE_COOL};
-  climate::ClimateFanMode fan_mode_{climate::CLIMATE_FAN_AUTO};
-};
-
-}  // namespace sinclair_asc18
-}  // namespace esphome
+#pragma once
+
+#include "esphome/components/gree_ac/gree_ac_cnt.h"
+
+namespace esphome {
+namespace sinclair_asc18 {
+
+// The ASC-18 module speaks the Gree CNT frame format, so the gree_ac engine does all the work;
+// only the protocol policy differs (see gree_ac::CNT::ASC18Protocol).
+using SinclairASC18Climate = gree_ac::CNT::GreeACCNTEngine<gree_ac::CNT::SinclairASC18Protocol>;
+
+}  // namespace sinclair_asc18
+}  // namespace esphome
@@ -1,5 +1,7 @@
 #include "protocol.h"
 
+#include <cmath>
+
 namespace esphome {
 namespace sinclair_c {
 namespace protocol {
@@ -17,29 +19,73 @@ size_t expected_length(const std::vector<uint8_t> &frame) {
 
 bool parse_status_short(const std::vector<uint8_t> &frame, Climate *cl) {
   // Beispiel: Temperatur extrahieren
-  uint8_t temp = frame[14];
-  cl->current_temperature = temp;
+  float temp = frame[14];
 
   // Modus
-  uint8_t mode = frame[20];
-  switch (mode) {
-    case 0x00: cl->mode = climate::CLIMATE_MODE_OFF; break;
-    case 0x01: cl->mode = climate::CLIMATE_MODE_COOL; break;
-    case 0x02: cl->mode = climate::CLIMATE_MODE_HEAT; break;
-    case 0x03: cl->mode = climate::CLIMATE_MODE_AUTO; break;
+  climate::ClimateMode mode = cl->mode;
+  switch (frame[20]) {
+    case 0x00: mode = climate::CLIMATE_MODE_OFF; break;
+    case 0x01: mode = climate::CLIMATE_MODE_COOL; break;
+    case 0x02: mode = climate::CLIMATE_MODE_HEAT; break;
+    case 0x03: mode = climate::CLIMATE_MODE_AUTO; break;
   }
 
+  // the unit repeats 0x82 continuously, only changes go to the API
+  if (temp == cl->current_temperature && mode == cl->mode)
+    return false;
+
+  cl->current_temperature = temp;
+  cl->mode = mode;
   cl->publish_state();
   return true;
 }
 
-bool parse_status_long(const std::vector<uint8_t> &frame, Climate *cl) {
-  // Erweiterte Sensorwerte
-  return true;
+static float read_field(const std::vector<uint8_t> &frame, const SensorField &field) {
+  const uint8_t *p = &frame[field.offset];
+  switch (field.type) {
+    case FieldType::S8: return (int8_t) p[0];
+    case FieldType::U16_LE: return (uint16_t) (p[0] | (p[1] << 8));
+    case FieldType::U16_BE: return (uint16_t) ((p[0] << 8) | p[1]);
+    case FieldType::U8:
+    default: return p[0];
+  }
 }
 
-bool parse_diag(const std::vector<uint8_t> &frame, Climate *cl) {
-  return true;
+// Decodes all configured fields of one frame in a single pass over the bank.
+static bool parse_sensors(const std::vector<uint8_t> &frame, std::vector<SensorField> &fields) {
+  const uint8_t cmd = frame[2];
+  const uint32_t now = millis();
+  bool published = false;
+
+  for (auto &field : fields) {
+    if (field.command != cmd)
+      continue;
+    if (field.published && now - field.last_publish < field.interval)
+      continue;
+
+    const size_t width = (field.type == FieldType::U16_LE || field.type == FieldType::U16_BE) ? 2 : 1;
+    if (field.offset + width > frame.size())
+      continue;
+
+    float value = read_field(frame, field) * field.multiplier + field.add;
+    if (field.published && (value == field.last_value || std::fabs(value - field.last_value) < field.threshold))
+      continue;
+
+    field.sensor->publish_state(value);
+    field.last_value = value;
+    field.last_publish = now;
+    field.published = true;
+    published = true;
+  }
+  return published;
+}
+
+bool parse_status_long(const std::vector<uint8_t> &frame, std::vector<SensorField> &fields) {
+  return parse_sensors(frame, fields);
+}
+
+bool parse_diag(const std::vector<uint8_t> &frame, std::vector<SensorField> &fields) {
+  return parse_sensors(frame, fields);
 }
 
 void build_control_frame(const ClimateCall &call, UARTDevice *dev) {
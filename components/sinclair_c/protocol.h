@@ -6,11 +6,28 @@ namespace esphome {
 namespace sinclair_c {
 namespace protocol {
 
+enum class FieldType : uint8_t { U8, S8, U16_LE, U16_BE };
+
+// One sensor of the 0x83 / 0x8F sensor bank.
+struct SensorField {
+  sensor::Sensor *sensor;
+  uint8_t command;     // 0x83 (long status) or 0x8F (diagnostics)
+  uint8_t offset;      // byte index in the frame, counted from the first 0x7E
+  FieldType type;
+  float multiplier;
+  float add;
+  float threshold;     // smaller changes are not published
+  uint32_t interval;   // minimum ms between two published states
+  uint32_t last_publish;
+  float last_value;    // as published, before any sensor filters
+  bool published;
+};
+
 size_t expected_length(const std::vector<uint8_t> &frame);
 
 bool parse_status_short(const std::vector<uint8_t> &frame, Climate *cl);
-bool parse_status_long(const std::vector<uint8_t> &frame, Climate *cl);
-bool parse_diag(const std::vector<uint8_t> &frame, Climate *cl);
+bool parse_status_long(const std::vector<uint8_t> &frame, std::vector<SensorField> &fields);
+bool parse_diag(const std::vector<uint8_t> &frame, std::vector<SensorField> &fields);
 
 void build_control_frame(const ClimateCall &call, UARTDevice *dev);
 
@@ -53,11 +53,11 @@ void SinclairC::process_frame(const std::vector<uint8_t> &frame) {
       break;
 
     case 0x83:
-      protocol::parse_status_long(frame, this);
+      protocol::parse_status_long(frame, this->sensors_);
       break;
 
     case 0x8F:
-      protocol::parse_diag(frame, this);
+      protocol::parse_diag(frame, this->sensors_);
       break;
 
     default:
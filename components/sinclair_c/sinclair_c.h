@@ -1,6 +1,7 @@
 #pragma once
 
 #include "esphome.h"
+#include "protocol.h"
 
 namespace esphome {
 namespace sinclair_c {
@@ -16,6 +17,13 @@ class SinclairC : public Component, public Climate, public UARTDevice {
   ClimateTraits traits() override;
   void control(const ClimateCall &call) override;
 
+  // Sensor bank for the long status (0x83) and diagnostics (0x8F) frames.
+  void add_sensor(sensor::Sensor *sensor, uint8_t command, uint8_t offset,
+                  protocol::FieldType type = protocol::FieldType::U8, float multiplier = 1.0f,
+                  float add = 0.0f, float threshold = 0.0f, uint32_t interval = 0) {
+    this->sensors_.push_back({sensor, command, offset, type, multiplier, add, threshold, interval, 0, NAN, false});
+  }
+
  protected:
   void parse_byte(uint8_t byte);
   void process_frame(const std::vector<uint8_t> &frame);
@@ -23,6 +31,7 @@ class SinclairC : public Component, public Climate, public UARTDevice {
 
   std::vector<uint8_t> rx_buffer_;
   uint32_t last_frame_ts_{0};
+  std::vector<protocol::SensorField> sensors_;
 };
 
 }  // namespace sinclair_c